@@ -8,6 +8,7 @@ struct Buffer
 {
     float* data;
     int width, height, fpp; // floats-per-element
+    int capacity;           // elements allocated, resizing within it keeps the allocation
 };
 
 void set_element      (int x, int y, float* elm, Buffer* buf);
@@ -16,6 +17,7 @@ void sample_bilinear  (float u, float v, float* smpl, Buffer* buf);
 void sample_nearest   (float u, float v, float* smpl, Buffer* buf);
 void clear_buffer     (const float* clear, Buffer* buf);
 void resize_buffer    (int width, int height, Buffer* buf);
+void reserve_buffer   (int width, int height, Buffer* buf);
 void init_buffer      (int width, int height, int fpp, Buffer* buf);
 void blit_buffer      (Buffer* src, Buffer* target, float x_offset, float y_offset, float width_percent, float height_percent);
 void map_sample_point (float* point, Buffer* src, Buffer* target, float* mapped_point);
\ No newline at end of file
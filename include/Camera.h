@@ -16,4 +16,7 @@ struct Camera
 };
 
 struct Frustum { float l, r, t, b, n, f; };
-Frustum get_frustum(Camera cam);
\ No newline at end of file
+Frustum get_frustum(Camera cam);
+
+// Looks at the origin from radius away, yaw and pitch give the look direction like the mouse look does
+void set_orbit_camera(float yaw, float pitch, float radius, Camera* camera);
@@ -0,0 +1,23 @@
+#pragma once
+#include "Geometry.h"
+#include "Mat.h"
+
+enum CullResult
+{
+    CULL_OUTSIDE,       // no part of the object is inside, skip it
+    CULL_INTERSECTING,  // faces need clipping
+    CULL_INSIDE         // every vertex is strictly inside every plane, no clipping needed
+};
+
+/**
+ * Classifies count objects against normalized view space planes, 4 objects at a time.
+ * 
+ * Each object's bounding sphere and box are moved to view space by its model-view matrix,
+ * the tighter of the two is used per plane. Inside is decided with a margin past epsilon,
+ * so that it agrees with the vertex stage's outcodes.
+ */
+void cull_objects(
+    const Plane* planes, int plane_count, float epsilon,
+    const Mat4x4f* model_views, const BoundingVolume* bounds, int count,
+    CullResult* results
+);
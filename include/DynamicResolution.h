@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * Dynamic resolution, picks the render scale that keeps render time within a budget.
+ *
+ * Render time is taken to grow with pixel count, so with the scale squared. Time is smoothed
+ * over frames, and only a sustained miss changes the scale:
+ *
+ *      over budget for a few frames        scale down to land just under it
+ *      under the low mark for many frames  scale up, a bounded step at a time
+ *      a single frame far over budget      scale down at once (load spike)
+ *
+ * Between the low mark and the budget nothing changes, so the scale does not oscillate.
+ */
+struct ResolutionController
+{
+    float budget_ms;
+    float min_scale, max_scale;
+    float scale;       // of the view size, per axis
+    float smoothed_ms; // moving average of render time, 0 before the first frame
+    int frames_over, frames_under;
+};
+
+void init_resolution_controller   (float budget_ms, float min_scale, float max_scale, ResolutionController* controller);
+bool update_resolution_controller (float render_ms, ResolutionController* controller); // true when scale changed
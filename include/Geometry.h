@@ -1,3 +1,4 @@
+#pragma once
 #include <vector>
 #include "Vertex.h"
 #include "Vec.h"
@@ -5,8 +6,27 @@
 
 struct Plane { float a, b, c, d; };
 
+// Object space bounds of a mesh, the sphere is centered on the box
+struct BoundingVolume
+{
+    Vec3f aabb_min, aabb_max;
+    Vec3f sphere_center;
+    float sphere_radius;
+};
+
+// Fixed capacity polygon for the clipper, lives on the stack
+const int MAX_CLIP_VERTICES = 32;
+struct ClipPolygon
+{
+    Vertex vertices[MAX_CLIP_VERTICES];
+    int count;
+};
+
 void cull_polygon(const std::vector<Vertex>& polygon, Plane plane, std::vector<Vertex>& in, std::vector<Vertex>& out, float epsilon = 0.001f);
 std::vector<Plane> get_frustum_planes(Frustum frustum);
+Plane normalized_plane(Plane plane);
+void clip_polygon(ClipPolygon& polygon, const Plane* planes, int plane_count, unsigned int plane_mask, float epsilon = 0.001f);
+BoundingVolume get_bounding_volume(const Vec3f* points, int count);
 
 Vec3f reflect_vector(const Vec3f& surface_normal, const Vec3f& vector);
 Vec3f get_triangle_normal(const Vec3f& a, const Vec3f& b, const Vec3f& c);
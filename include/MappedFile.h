@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+
+// Read-only view of a whole file, memory-mapped
+struct MappedFile
+{
+    const char* data;
+    size_t size;
+
+    void* handle; // platform specific
+};
+
+// Copy-on-write maps pages writable, writes stay private to the process and never reach the file
+bool map_file(const char* filename, MappedFile* file, bool is_copy_on_write = false);
+void unmap_file(MappedFile* file);
@@ -1,3 +1,4 @@
+#pragma once
 #include "Vec.h"
 
 struct Mat3x3f
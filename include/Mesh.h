@@ -1,14 +1,48 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include "Vec.h"
+#include "Geometry.h"
 
-class Mesh 
+// Arrays owned by a mesh loaded from source files, empty for a mesh that views a pack file
+struct MeshStorage
 {
-public:
 	std::vector<Vec3f> vertices;
 	std::vector<Vec2f> uvs;
-	std::vector<std::vector<int>> faces;
+	std::vector<Vec3f> normals;
+	std::vector<uint32_t> indices;
+	std::vector<float> positions_x, positions_y, positions_z;
+};
+
+/**
+ * Triangle mesh, indexed.
+ * 
+ * Every vertex is one unique (position, uv, normal) combination of the source file,
+ * triangles are 3 indices each, counter-clockwise seen from the front.
+ */
+class Mesh 
+{
+public:
+	// Read-only views, point either into storage or straight into a mapped pack file
+	const Vec3f*    vertices; int vertex_count;
+	const Vec2f*    uvs;                        // one per vertex, (0, 0) where the file gave none
+	const Vec3f*    normals;  int normal_count; // one per vertex, or none at all when the file had none
+	const uint32_t* indices;  int triangle_count;
+
+	// Structure-of-arrays copy of vertices, for the batched vertex stage
+	const float *positions_x, *positions_y, *positions_z;
+
+	BoundingVolume bounds;
+
+	MeshStorage storage;
+
+	bool is_loaded; // false when the model file could not be read, the mesh is then empty
+
+	Mesh();
+	Mesh(const char *filename, bool is_reordered = true); // is_reordered: optimize_triangle_order, see MeshOptimize.h
+	Mesh(const Mesh&) = delete; // views would point into the other mesh's storage
+	Mesh& operator = (const Mesh&) = delete;
 
-	Mesh(const char *filename);
-};
\ No newline at end of file
+	void update_from_storage();
+};
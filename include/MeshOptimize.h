@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include "Vec.h"
+
+// Simulated post-transform cache, the size Tipsify aims for and ACMR is measured with
+const int VERTEX_CACHE_SIZE = 16;
+
+/**
+ * Reorders triangles in place for vertex locality, then for less overdraw (Tipsify,
+ * Sander, Nehab & Barczak 2007).
+ *
+ * Triangles are fanned out around vertices that are still in the simulated cache, the
+ * order is then cut into clusters wherever the cache locality allows, and clusters are
+ * sorted so that those facing outward, away from the mesh center, are drawn first.
+ * Each triangle keeps its winding.
+ */
+void optimize_triangle_order(uint32_t* indices, int triangle_count, const Vec3f* vertices, int vertex_count);
+
+// Average cache miss ratio, vertices transformed per triangle with a FIFO cache of cache_size
+float get_acmr(const uint32_t* indices, int triangle_count, int vertex_count, int cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * Average overdraw with an early depth test, fragments passing the test per covered pixel.
+ *
+ * Rasterizes the front faces orthographically from view_count directions spread over a
+ * sphere, into a resolution x resolution grid around the mesh bounds.
+ */
+float get_overdraw(const uint32_t* indices, int triangle_count, const Vec3f* vertices, int vertex_count, int view_count = 16, int resolution = 256);
@@ -1,7 +1,11 @@
 #pragma once
 #include "Vec.h"
 #include "Mesh.h"
-#include "Buffer.h"
+#include "Texture.h"
+
+// Which faces get dropped before clipping, by which way they face the camera
+// NOTE: front faces wind counter-clockwise, seen from the camera
+enum FaceCullMode { FACE_CULL_BACK, FACE_CULL_FRONT, FACE_CULL_NONE };
 
 struct Object
 {
@@ -14,5 +18,7 @@ struct Object
     float yaw, pitch, roll;
 
     Mesh* mesh;
-    Buffer* texture;
+    Texture* texture; // acquired from the scene's TextureManager, shared between objects
+
+    FaceCullMode face_cull_mode = FACE_CULL_BACK; // ASSUMPTION: meshes are closed, set to none otherwise
 };
\ No newline at end of file
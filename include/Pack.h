@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Mesh.h"
+#include "Texture.h"
+#include "MappedFile.h"
+
+/**
+ * Baked asset pack, one file holding indexed meshes and textures in their runtime layout,
+ * so that opening one is a mmap and some pointer fix ups, no parsing or converting.
+ * 
+ * header, mesh table, texture table, then the arrays, every array PACK_ALIGNMENT aligned.
+ * Offsets are from the start of the file.
+ * 
+ * ASSUMPTION: little endian, and float/struct layout of the machine that baked it
+ */
+
+const char PACK_MAGIC[4] = { 'S', 'R', 'P', 'K' };
+const uint32_t PACK_VERSION = 5;
+const int PACK_NAME_SIZE = 64;
+const int PACK_ALIGNMENT = 64;
+
+struct PackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t mesh_count, texture_count;
+    uint64_t meshes_offset, textures_offset; // PackMesh and PackTexture tables
+};
+
+struct PackMesh
+{
+    char name[PACK_NAME_SIZE];
+    BoundingVolume bounds;
+    int32_t vertex_count, normal_count, triangle_count;
+    uint64_t vertices, uvs, normals, indices, positions_x, positions_y, positions_z;
+};
+
+// Level 0 is the full size texture, every next level is half the size
+struct PackTexture
+{
+    char name[PACK_NAME_SIZE];
+    int32_t width, height, format, layout, level_count; // a TextureFormat and a TextureLayout
+    uint64_t levels[MAX_TEXTURE_LEVELS];
+};
+
+struct Pack
+{
+    MappedFile file;
+    std::vector<const char*> mesh_names, texture_names;
+    std::vector<Mesh*> meshes; // views into the file
+    std::vector<Texture*> textures; // views into the file
+};
+
+// Meshes and textures view the read-only mapping, they stay valid until close_pack
+bool     open_pack         (const char* filename, Pack* pack);
+void     close_pack        (Pack* pack);
+Mesh*    find_pack_mesh    (Pack* pack, const char* name);
+Texture* find_pack_texture (Pack* pack, const char* name);
+
+struct PackContents
+{
+    std::vector<const char*> mesh_names;
+    std::vector<const Mesh*> meshes;
+
+    std::vector<const char*> texture_names;
+    std::vector<const Texture*> textures; // with their mip chains
+};
+
+bool write_pack(const char* filename, const PackContents& contents);
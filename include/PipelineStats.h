@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Pipeline statistics of one frame, like a GPU's pipeline statistics query.
+ *
+ * Every stage counts into its own task's or worker's copy and render_scene sums them
+ * at the end, so counting needs no atomics.
+ */
+struct PipelineStats
+{
+    uint64_t objects_submitted;
+    uint64_t objects_culled;        // outside the frustum
+    uint64_t faces_submitted;       // triangles of objects that were not culled
+    uint64_t faces_backface_culled; // by the object's face cull mode
+    uint64_t faces_rejected;        // outside a frustum plane, clipped away or off screen
+    uint64_t polygons_clipped;      // faces that crossed near, far or the guard band
+    uint64_t polygons_binned;
+    uint64_t triangles_binned;      // binned polygons as fans, the same for either rasterizer and tile size
+    uint64_t bin_entries;           // polygon and tile pairs
+    uint64_t triangles_rasterized;  // per tile, as the rasterizers split polygons
+    uint64_t fragments_generated;
+    uint64_t depth_passes;
+    uint64_t depth_fails;
+    uint64_t pixels_covered;        // pixels that passed a depth test at least once
+    uint64_t pixel_count;
+};
+
+void  add_pipeline_stats         (const PipelineStats& stats, PipelineStats& total);
+float get_frame_overdraw         (const PipelineStats& stats); // shaded fragments per covered pixel
+float get_frame_depth_complexity (const PipelineStats& stats); // generated fragments per covered pixel
+
+// Per frame statistics file, CSV or (for a .json path) a JSON array with an object per frame
+struct StatsWriter
+{
+    FILE* file;
+    bool is_json;
+    int frame_count;
+};
+
+bool open_stats_writer  (const char* path, StatsWriter* writer);
+void write_stats_frame  (const PipelineStats& stats, StatsWriter* writer);
+void close_stats_writer (StatsWriter* writer);
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Presentation, float RGB frames to 8-bit window pixels.
+ *
+ * Frames are bottom row first and windows top row first, the flip is done by walking
+ * destination row pointers backwards. Rows are split across the worker pool.
+ * NOTE: nothing in here depends on SDL, so the tools can time it
+ */
+
+// Byte order of a pixel in memory, alpha is always written opaque
+enum PixelOrder { PIXEL_RGBA, PIXEL_BGRA };
+
+struct PresentTarget
+{
+    uint8_t* pixels; // top row first
+    int width, height;
+    int pitch;       // bytes from one row to the next
+    PixelOrder order;
+};
+
+// rgb is target sized, 3 floats per pixel, clamped to 0 to 1, then sRGB encoded through a LUT when asked to
+void present_pixels(const float* rgb, bool is_srgb, const PresentTarget& target);
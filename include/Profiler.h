@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Frame profiler, scoped timers per pipeline stage.
+ *
+ * Every worker records into its own ring of events (single writer, so no locks), the newest
+ * events overwrite the oldest. end_profiler_frame folds the frame's events into a per-stage
+ * history: a stage's time in a frame is the sum of its events over all workers, so it is busy
+ * time (a parallel stage can add up to more than the frame, and stages nested in another one,
+ * like the tile clears in raster, are counted in both). The rings can be dumped as a Chrome
+ * trace (chrome://tracing, Perfetto).
+ *
+ * NOTE: timers are off until set_profiling, a disabled scope costs one branch
+ */
+
+enum ProfileStage
+{
+    STAGE_FRAME,    // whole frame, as the caller defines it
+    STAGE_CULL,     // object culling and draw setup
+    STAGE_VERTEX,   // vertex transform and outcodes
+    STAGE_CLIP,     // face culling, clipping, projection and binning
+    STAGE_RASTER,   // rasterization with fused fragment shading, per tile
+    STAGE_CLEAR,    // lazy tile clears (inside raster) and whole buffer clears
+    STAGE_RESOLVE,  // packed frame buffer to floats
+    STAGE_BLIT,     // resolution scaling
+    STAGE_PRESENT,  // conversion to window pixels
+    STAGE_COUNT
+};
+
+struct ProfileStats
+{
+    float min_ms, avg_ms, p99_ms;
+    int frame_count; // frames the stage ran in, out of the history
+};
+
+void         init_profiler      (int worker_count); // worker indices as given by parallel_for
+void         set_profiling      (bool is_enabled);
+void         end_profiler_frame ();
+ProfileStats get_stage_stats    (ProfileStage stage);
+const char*  get_stage_name     (ProfileStage stage);
+void         print_profile      (); // stats of every stage that ran, one line each
+bool         write_chrome_trace (const char* path);
+
+extern bool is_profiling;
+
+void record_profile_event (ProfileStage stage, int worker, uint64_t start_ns, uint64_t end_ns);
+uint64_t get_profile_time (); // ns since init_profiler
+
+struct ProfileScope
+{
+    ProfileStage stage;
+    int worker;
+    bool is_timed;
+    uint64_t start_ns;
+
+    ProfileScope(ProfileStage stage, int worker) : stage(stage), worker(worker), is_timed(is_profiling), start_ns(is_timed ? get_profile_time() : 0) {}
+    ~ProfileScope() { end(); }
+
+    // Ends the scope early, for a stage that is only the first part of a block
+    void end()
+    {
+        if (is_timed) record_profile_event(stage, worker, start_ns, get_profile_time());
+        is_timed = false;
+    }
+};
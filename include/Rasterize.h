@@ -2,7 +2,10 @@
 #include "Vec.h"
 #include "Buffer.h"
 #include <vector>
+#include <cmath>
 #include "Vertex.h"
+#include "Simd.h"
+#include "Util.h"
 #include "tgaimage.h"
 
 struct Fragment
@@ -14,11 +17,239 @@ struct Fragment
     float depth;
 };
 
+// Triangle engines, scanline walks flat top/bottom triangles, half-space evaluates edge functions on pixel blocks
+enum RasterMode { RASTER_SCANLINE, RASTER_HALF_SPACE };
+
+// Pixel rectangle [x0, x1) x [y0, y1), fragments are only generated inside of it
+struct Rect { int x0, y0, x1, y1; };
+
 void rasterize_point(const Vertex& v, int width, std::vector<Fragment>& fragments);
 void rasterize_line(const Vertex& v0, const Vertex& v1, int width, std::vector<Fragment>& fragments);
 void rasterize_polygon(const std::vector<Vertex>& vertices, int height, int width, std::vector<Fragment>& fragments);
+void rasterize_polygon(const std::vector<Vertex>& vertices, const Rect& bounds, std::vector<Fragment>& fragments);
+void rasterize_polygon_half_space(const std::vector<Vertex>& vertices, const Rect& bounds, std::vector<Fragment>& fragments);
 
 // NOTE: currently, rasterizer expect in-bounds device coordinates
 //          if they are out-of-bounds, and the primitive to render
 //          is large, then it will still try to rasterizer every pixel it covers
-//          this can really slow down performance, halt it even
\ No newline at end of file
+//          this can really slow down performance, halt it even
+
+
+/**
+ * Fused raster entry points
+ * 
+ * Instead of filling a list of fragments, these call the fragment stage
+ * for every covered pixel right inside the span loop:
+ * 
+ *      stage(int x, int y, float depth, const Vec2f& uv)
+ *      stage.set_uv_gradients(const Vec2f& duv_dx, const Vec2f& duv_dy), before the pixels of a triangle
+ * 
+ * The stage is a template parameter so the call gets inlined (depth test,
+ * texture sample and store happen in the loop with no fragment storage).
+ * The std::vector<Fragment> versions above are these with a FragmentCollector.
+ */
+
+// Fragment stage that just stores the fragments, for callers that want them in a list
+struct FragmentCollector
+{
+    std::vector<Fragment>& fragments;
+
+    void set_uv_gradients(const Vec2f&, const Vec2f&) {}
+
+    void operator()(int x, int y, float depth, const Vec2f& uv)
+    {
+        Fragment frag;
+        frag.pixel = Vec2i(x, y);
+        frag.depth = depth;
+        frag.uv = uv;
+        fragments.push_back(frag);
+    }
+};
+
+// Scanline engine, edges and spans are evaluated directly from their start instead of
+// accumulating steps, so the fragments of a pixel do not depend on the raster bounds
+struct ScanlineTriangle
+{
+    int start_scanline;                // steps are counted from here
+    int first_scanline, stop_scanline; // clamped to bounds
+    float delta_y;                     // from the start vertex to the first scanline
+    float left_x, left_x_inc;
+    float right_x, right_x_inc;
+    float left_depth, left_depth_inc;
+    Vec2f left_uv, left_uv_inc;
+    float span_depth_inc;
+    Vec2f span_uv_inc;
+};
+
+// Triangle must be flat top/bottom, returns false when there is nothing to rasterize
+bool set_up_scanline_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Rect& bounds, ScanlineTriangle& tri);
+
+// Screen space uv change per pixel in x and y, of the polygon's largest fan triangle
+// NOTE: clipped polygons are not exactly one uv plane, the largest triangle is the best fit and never a sliver
+void get_uv_gradients(const Vertex* vertices, int vertex_count, Vec2f& duv_dx, Vec2f& duv_dy);
+
+// Cuts polygon at every vertex height into flat top/bottom triangles (3 vertices each)
+void split_polygon(const Vertex* vertices, int vertex_count, std::vector<Vertex>& triangles);
+
+template <class FragmentStage>
+void rasterize_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Rect& bounds, FragmentStage& stage)
+{
+    ScanlineTriangle tri;
+    if (!set_up_scanline_triangle(v0, v1, v2, bounds, tri)) return;
+
+    for (int scanline = tri.first_scanline; scanline < tri.stop_scanline; scanline++)
+    {
+        float scanline_step = tri.delta_y + (scanline - tri.start_scanline);
+        float left_x  = tri.left_x  + tri.left_x_inc  * scanline_step;
+        float right_x = tri.right_x + tri.right_x_inc * scanline_step;
+
+        // Span start, only the attributes that end up in a fragment
+        float left_depth = tri.left_depth + tri.left_depth_inc * scanline_step;
+        Vec2f left_uv (tri.left_uv.x + tri.left_uv_inc.x * scanline_step, tri.left_uv.y + tri.left_uv_inc.y * scanline_step);
+
+        int first_column = floor(left_x);
+        float delta_x = (first_column - left_x);
+
+        int column = max_i(bounds.x0, first_column); // ROBUSTNESS
+        int stop_column = min_i(bounds.x1, floor(right_x)); // ROBUSTNESS
+        for (; column < stop_column; column++)
+        {
+            float column_step = delta_x + (column - first_column);
+            stage(column, scanline, left_depth + tri.span_depth_inc * column_step, Vec2f(left_uv.x + tri.span_uv_inc.x * column_step, left_uv.y + tri.span_uv_inc.y * column_step));
+        }
+    }
+}
+
+// Returns the number of triangles the polygon was split into
+template <class FragmentStage>
+int rasterize_polygon(const Vertex* vertices, int vertex_count, const Rect& bounds, FragmentStage& stage)
+{
+    thread_local std::vector<Vertex> triangles;
+    triangles.clear();
+    split_polygon(vertices, vertex_count, triangles);
+
+    // Slabs of one polygon share its gradients, thin slabs would give poor ones of their own
+    Vec2f duv_dx, duv_dy;
+    get_uv_gradients(vertices, vertex_count, duv_dx, duv_dy);
+    stage.set_uv_gradients(duv_dx, duv_dy);
+
+    for (int i = 0; i + 2 < triangles.size(); i += 3)
+    {
+        rasterize_triangle(triangles[i], triangles[i + 1], triangles[i + 2], bounds, stage);
+    }
+    return triangles.size() / 3;
+}
+
+// Half-space engine
+
+// E(x, y) = A*(x - origin.x) + B*(y - origin.y), positive on the inside of a counter-clockwise triangle
+struct EdgeFunction
+{
+    float a, b;
+    Vec2f origin;
+    bool is_top_left; // pixel centers exactly on the edge belong to top-left edges only
+};
+
+// Attribute that varies linearly over the triangle, f(x, y) = f + dx*(x - origin.x) + dy*(y - origin.y)
+struct AttributePlane
+{
+    float f, dx, dy;
+};
+
+const int RASTER_BLOCK_SIZE = 4; // pixel blocks are 4x4, one SIMD row of 4 at a time
+
+struct HalfSpaceTriangle
+{
+    EdgeFunction edges[3];
+    Vec2f origin; // of the attribute planes
+    AttributePlane depth, u, v;
+    int x0, y0, x1, y1; // block aligned start, clamped end
+};
+
+// Returns false when there is nothing to rasterize
+bool set_up_half_space_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Rect& bounds, HalfSpaceTriangle& tri);
+
+template <class FragmentStage>
+void rasterize_triangle_half_space(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Rect& bounds, FragmentStage& stage)
+{
+    /**
+     * PROCESS:
+     * 
+     * for each 4x4 pixel block in triangle bounding box (inside bounds)
+     *      skip block if it is completely outside of an edge
+     *      for each row of block
+     *          evaluate edge functions for 4 pixel centers at once -> coverage mask
+     *          evaluate attributes for 4 pixel centers at once
+     *          run fragment stage for every covered pixel
+     */
+
+    HalfSpaceTriangle tri;
+    if (!set_up_half_space_triangle(v0, v1, v2, bounds, tri)) return;
+    stage.set_uv_gradients(Vec2f(tri.u.dx, tri.v.dx), Vec2f(tri.u.dy, tri.v.dy));
+
+    const Float4 LANE_OFFSETS = float4(0.5f, 1.5f, 2.5f, 3.5f); // pixel centers
+    const Float4 ZERO = float4(0.0f);
+
+    Float4 edge_steps[3];
+    for (int e = 0; e < 3; e++) edge_steps[e] = float4(tri.edges[e].a) * LANE_OFFSETS;
+    Float4 depth_steps = float4(tri.depth.dx) * LANE_OFFSETS;
+    Float4 u_steps     = float4(tri.u.dx)     * LANE_OFFSETS;
+    Float4 v_steps     = float4(tri.v.dx)     * LANE_OFFSETS;
+
+    float lane_depth[4], lane_u[4], lane_v[4];
+
+    for (int block_y = tri.y0; block_y < tri.y1; block_y += RASTER_BLOCK_SIZE)
+    {
+        for (int block_x = tri.x0; block_x < tri.x1; block_x += RASTER_BLOCK_SIZE)
+        {
+            // Trivial reject, largest edge value over the block's pixel centers is still outside
+            bool is_outside = false;
+            for (int e = 0; e < 3; e++)
+            {
+                const EdgeFunction& edge = tri.edges[e];
+                float corner = edge.a * (block_x + 0.5f - edge.origin.x) + edge.b * (block_y + 0.5f - edge.origin.y);
+                float max_value = corner + maxf(edge.a, 0.0f) * (RASTER_BLOCK_SIZE - 1) + maxf(edge.b, 0.0f) * (RASTER_BLOCK_SIZE - 1);
+                is_outside = is_outside || max_value < 0.0f;
+            }
+            if (is_outside) continue;
+
+            // Columns past the bounds are masked off
+            int columns_mask = (1 << min_i(RASTER_BLOCK_SIZE, bounds.x1 - block_x)) - 1;
+            float dx = block_x - tri.origin.x;
+
+            for (int y = block_y; y < min_i(block_y + RASTER_BLOCK_SIZE, bounds.y1); y++)
+            {
+                int mask = columns_mask;
+                for (int e = 0; e < 3; e++)
+                {
+                    const EdgeFunction& edge = tri.edges[e];
+                    float row = edge.a * (block_x - edge.origin.x) + edge.b * (y + 0.5f - edge.origin.y);
+                    Float4 value = float4(row) + edge_steps[e];
+                    mask &= move_mask(edge.is_top_left ? cmp_ge(value, ZERO) : cmp_gt(value, ZERO));
+                }
+                if (mask == 0) continue;
+
+                float dy = y + 0.5f - tri.origin.y;
+                store_float4(lane_depth, float4(tri.depth.f + tri.depth.dy * dy + tri.depth.dx * dx) + depth_steps);
+                store_float4(lane_u,     float4(tri.u.f     + tri.u.dy     * dy + tri.u.dx     * dx) + u_steps);
+                store_float4(lane_v,     float4(tri.v.f     + tri.v.dy     * dy + tri.v.dx     * dx) + v_steps);
+
+                for (int i = 0; i < RASTER_BLOCK_SIZE; i++)
+                {
+                    if (mask & (1 << i)) stage(block_x + i, y, lane_depth[i], Vec2f(lane_u[i], lane_v[i]));
+                }
+            }
+        }
+    }
+}
+
+// Polygon is assumed convex (clipped polygons are), it is fanned into triangles, returns their number
+template <class FragmentStage>
+int rasterize_polygon_half_space(const Vertex* vertices, int vertex_count, const Rect& bounds, FragmentStage& stage)
+{
+    for (int i = 1; i + 1 < vertex_count; i++)
+    {
+        rasterize_triangle_half_space(vertices[0], vertices[i], vertices[i + 1], bounds, stage);
+    }
+    return max_i(0, vertex_count - 2);
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Buffer.h"
+#include "PipelineStats.h"
+#include "Rasterize.h"
+#include "Scene.h"
+#include "Texture.h"
+#include "Util.h"
+#include "tgaimage.h"
+
+// Screen is split into square tiles that are rasterized in parallel
+const int TILE_SIZE = 64;
+
+// Color is 32 bits per pixel, red in the lowest bits, alpha is always opaque
+enum ColorFormat { COLOR_RGBA8, COLOR_RGB10A2 };
+
+// Integer depths map view depth from far (0) to near (max), 24-bit depth sits in the low bits of a 32-bit word
+enum DepthFormat { DEPTH_32F, DEPTH_24, DEPTH_16 };
+
+/**
+ * Render target, packed color and depth plus a clear epoch per screen tile.
+ *
+ * Clearing only bumps the epoch. The raster stage clears a tile the first time it draws into it
+ * after that, while the tile is in its worker's cache, and tiles nothing is drawn into are never
+ * written at all (resolve_frame_buffer reads them back as the clear color).
+ */
+struct FrameBuffer
+{
+    ColorFormat color_format;
+    DepthFormat depth_format;
+    int width, height;
+    int tiles_x, tiles_y;
+
+    std::vector<uint32_t> color;
+    std::vector<uint8_t> depth; // get_depth_size bytes per pixel
+
+    uint32_t epoch;
+    std::vector<uint32_t> tile_epochs; // a tile behind epoch holds stale pixels, it reads as cleared
+    Vec3f clear_color;
+    float depth_scale, depth_offset;   // view depth to 0 at far and 1 at near, set by render_scene
+};
+struct RenderSettings
+{
+    RasterMode raster_mode = RASTER_SCANLINE;
+    TextureFilter texture_filter = FILTER_TRILINEAR;
+} extern render_settings;
+
+void init_frame_buffer    (int width, int height, ColorFormat color_format, DepthFormat depth_format, FrameBuffer* frame_buffer);
+void resize_frame_buffer  (int width, int height, FrameBuffer* frame_buffer);
+void reserve_frame_buffer (int width, int height, FrameBuffer* frame_buffer); // storage for up to width x height, size is kept
+void clear_frame_buffer   (const Vec3f& clear_color, FrameBuffer* frame_buffer);
+void resolve_frame_buffer (const FrameBuffer* frame_buffer, Buffer* color); // color is frame buffer sized, 3 floats per element
+
+inline int get_depth_size(DepthFormat format) { return format == DEPTH_16 ? 2 : 4; }
+
+// NOTE: same rounding as buffer_to_tga_image, so an RGBA8 frame writes out the same image a float one did
+inline uint32_t pack_color(const float* rgb, ColorFormat format)
+{
+    float scale = format == COLOR_RGBA8 ? 255.9999f : 1023.9999f;
+    uint32_t r = clampf(rgb[0], 0.0f, 1.0f) * scale;
+    uint32_t g = clampf(rgb[1], 0.0f, 1.0f) * scale;
+    uint32_t b = clampf(rgb[2], 0.0f, 1.0f) * scale;
+
+    if (format == COLOR_RGBA8) return r | (g << 8) | (b << 16) | (0xFFu << 24);
+    return r | (g << 10) | (b << 20) | (0x3u << 30);
+}
+
+// Depth test and write of pixel i, larger depth is nearer, returns whether the fragment is visible
+inline bool test_depth(int i, float depth, FrameBuffer* frame_buffer)
+{
+    if (frame_buffer->depth_format == DEPTH_32F)
+    {
+        float* stored = (float*) frame_buffer->depth.data() + i;
+        if (*stored > depth) return false;
+        *stored = depth;
+        return true;
+    }
+
+    float normalized = clampf(depth * frame_buffer->depth_scale + frame_buffer->depth_offset, 0.0f, 1.0f);
+    if (frame_buffer->depth_format == DEPTH_24)
+    {
+        uint32_t* stored = (uint32_t*) frame_buffer->depth.data() + i;
+        uint32_t quantized = normalized * 16777215.0f + 0.5f;
+        if (*stored > quantized) return false;
+        *stored = quantized;
+        return true;
+    }
+
+    uint16_t* stored = (uint16_t*) frame_buffer->depth.data() + i;
+    uint16_t quantized = normalized * 65535.0f + 0.5f;
+    if (*stored > quantized) return false;
+    *stored = quantized;
+    return true;
+}
+
+// Whether pixel i still holds the clear depth, that is nothing passed the depth test there yet
+// NOTE: an integer depth fragment exactly on the far plane is indistinguishable from the clear value
+inline bool is_depth_cleared(int i, const FrameBuffer* frame_buffer)
+{
+    if (frame_buffer->depth_format == DEPTH_32F) return ((const float*) frame_buffer->depth.data())[i] == MAX_DEPTH;
+    if (frame_buffer->depth_format == DEPTH_24)  return ((const uint32_t*) frame_buffer->depth.data())[i] == 0;
+    return ((const uint16_t*) frame_buffer->depth.data())[i] == 0;
+}
+
+// Fragment stage of the fused raster path: depth test, texture sample and store
+// ASSUMPTION: pixel is in bounds (rasterizer clips to the tile it works on)
+struct ShadeFragment
+{
+    FrameBuffer* frame_buffer;
+    const Texture* texture;
+    TextureFilter filter;
+    PipelineStats* stats; // the worker's own
+    float lod = 0.0f;
+
+    // uv is affine in screen space, so the derivatives of a 2x2 quad are the same all over the triangle
+    void set_uv_gradients(const Vec2f& duv_dx, const Vec2f& duv_dy)
+    {
+        lod = get_texture_lod(texture, duv_dx.x, duv_dx.y, duv_dy.x, duv_dy.y);
+    }
+
+    void operator()(int x, int y, float depth, const Vec2f& uv)
+    {
+        int i = x + y * frame_buffer->width;
+        bool was_cleared = is_depth_cleared(i, frame_buffer);
+        stats->fragments_generated++;
+        if (!test_depth(i, depth, frame_buffer))
+        {
+            stats->depth_fails++;
+            return;
+        }
+        stats->depth_passes++;
+        stats->pixels_covered += was_cleared;
+
+        float color[4];
+        store_float4(color, sample_texture(clampf(uv.x, 0.0f, 1.0f), clampf(uv.y, 0.0f, 1.0f), lod, filter, texture));
+        frame_buffer->color[i] = pack_color(color, frame_buffer->color_format);
+    }
+};
+
+void          render_scene       (Scene& scene, FrameBuffer* frame_buffer);
+PipelineStats get_pipeline_stats (); // of the last render_scene
+void set_fragment (Fragment& frag, FrameBuffer* frame_buffer, const Texture* texture);
+
+Buffer*  tga_image_to_buffer (TGAImage& img);
+TGAImage buffer_to_tga_image (Buffer* buffer);
+
+// NOTE: nothing in here may depend on SDL, the headless build links without it
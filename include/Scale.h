@@ -0,0 +1,14 @@
+#pragma once
+#include "Buffer.h"
+
+/**
+ * Resolution scaler, resamples a 3 float per element buffer into a region of another.
+ *
+ * Integer ratios take fast paths: an n times bigger region repeats every source pixel n x n
+ * times, an n times smaller one averages n x n blocks. Anything else is bilinear, run as
+ * a horizontal then a vertical pass with per-column and per-row weights worked out once.
+ * Target rows are split across the worker pool.
+ */
+
+// Region is in target pixels (bottom left x, y), clipped to the target
+void scale_buffer (const Buffer* src, Buffer* target, int x, int y, int width, int height);
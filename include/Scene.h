@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Camera.h"
+#include "Object.h"
+#include "Mat.h"
+
+struct Scene
+{
+    Camera camera;
+    std::vector<Object> objects;
+    TextureManager textures;
+
+    Mat4x4f world; // applied on top of every object's own transform
+};
+
+/**
+ * Procedural stress scene, for measuring how the renderer scales along one axis at a time.
+ *
+ * Every object is a flat grid of equal triangles facing a fixed camera (at the origin, looking
+ * down -z), tilted a little and spun around its center, at a random depth. Triangle sizes are
+ * edge lengths in view heights as seen on screen (0.01 is about 11 pixels at 1080 rows), every
+ * object picks one log-uniformly from the range. Objects are scattered over a view centered
+ * region sized so that their summed screen area is depth_complexity times the region's area.
+ * A region bigger than the view spills off screen, and random placement leaves gaps, so the
+ * measured depth complexity (get_frame_depth_complexity) comes out somewhat higher than
+ * asked for at low values. Textures are checkerboards, handed out to the objects in turn.
+ * Same settings and seed give the same scene.
+ */
+struct StressSceneSettings
+{
+    int object_count = 64;
+    int triangles_per_object = 128;
+    float min_triangle_size = 0.01f;
+    float max_triangle_size = 0.05f;
+    float depth_complexity = 2.0f;
+    int texture_count = 4;
+    uint32_t seed = 1;
+};
+
+void init_rubik_scene  (Scene& scene);
+void init_stress_scene (const StressSceneSettings& settings, Scene& scene); // ASSUMPTION: camera.aspect_ratio is set, the rest of the camera is set here
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Thin 4-wide float vector, maps onto SSE when the compiler has it,
+ * otherwise falls back to plain scalar loops (same results either way).
+ * 
+ * Comparisons return lane masks (all bits set, or zero) that can be
+ * combined with mask_and and read back with move_mask (bit i = lane i).
+ */
+
+#if defined(__SSE2__)
+
+struct Float4 { __m128 v; };
+
+inline Float4 float4(float s)                              { return Float4 { _mm_set1_ps(s) }; }
+inline Float4 float4(float a, float b, float c, float d)   { return Float4 { _mm_setr_ps(a, b, c, d) }; }
+inline Float4 load_float4(const float* p)                  { return Float4 { _mm_loadu_ps(p) }; }
+inline void   store_float4(float* p, Float4 a)             { _mm_storeu_ps(p, a.v); }
+
+inline Float4 operator + (Float4 a, Float4 b) { return Float4 { _mm_add_ps(a.v, b.v) }; }
+inline Float4 operator - (Float4 a, Float4 b) { return Float4 { _mm_sub_ps(a.v, b.v) }; }
+inline Float4 operator * (Float4 a, Float4 b) { return Float4 { _mm_mul_ps(a.v, b.v) }; }
+inline Float4 operator / (Float4 a, Float4 b) { return Float4 { _mm_div_ps(a.v, b.v) }; }
+
+// 4 unsigned bytes widened to 4 floats (0 to 255)
+inline Float4 load_bytes4(const uint8_t* p)
+{
+    int packed;
+    memcpy(&packed, p, 4);
+    __m128i zero = _mm_setzero_si128();
+    __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+    return Float4 { _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero)) };
+}
+
+// Lanes truncated to ints, stored as 16 unsigned bytes (saturated to 0 to 255), a's lanes first
+inline void store_bytes16(uint8_t* p, Float4 a, Float4 b, Float4 c, Float4 d)
+{
+    __m128i ab = _mm_packs_epi32(_mm_cvttps_epi32(a.v), _mm_cvttps_epi32(b.v));
+    __m128i cd = _mm_packs_epi32(_mm_cvttps_epi32(c.v), _mm_cvttps_epi32(d.v));
+    _mm_storeu_si128((__m128i*) p, _mm_packus_epi16(ab, cd));
+}
+
+inline void store_int4(int32_t* p, Float4 a) { _mm_storeu_si128((__m128i*) p, _mm_cvttps_epi32(a.v)); } // truncated
+
+// Lane i of the result is lane (i-th template argument) of a
+template <int x, int y, int z, int w> inline Float4 shuffle(Float4 a) { return Float4 { _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(w, z, y, x)) }; }
+
+inline Float4 min_float4 (Float4 a, Float4 b) { return Float4 { _mm_min_ps(a.v, b.v) }; }
+inline Float4 max_float4 (Float4 a, Float4 b) { return Float4 { _mm_max_ps(a.v, b.v) }; }
+
+inline Float4 cmp_ge   (Float4 a, Float4 b) { return Float4 { _mm_cmpge_ps(a.v, b.v) }; }
+inline Float4 cmp_gt   (Float4 a, Float4 b) { return Float4 { _mm_cmpgt_ps(a.v, b.v) }; }
+inline Float4 cmp_lt   (Float4 a, Float4 b) { return Float4 { _mm_cmplt_ps(a.v, b.v) }; }
+inline Float4 mask_and (Float4 a, Float4 b) { return Float4 { _mm_and_ps(a.v, b.v) }; }
+inline Float4 mask_or  (Float4 a, Float4 b) { return Float4 { _mm_or_ps(a.v, b.v) }; }
+inline int    move_mask(Float4 a)           { return _mm_movemask_ps(a.v); }
+
+#else
+
+struct Float4 { float v[4]; };
+
+inline Float4 float4(float s)                              { return Float4 { { s, s, s, s } }; }
+inline Float4 float4(float a, float b, float c, float d)   { return Float4 { { a, b, c, d } }; }
+inline Float4 load_float4(const float* p)                  { return Float4 { { p[0], p[1], p[2], p[3] } }; }
+inline void   store_float4(float* p, Float4 a)             { for (int i = 0; i < 4; i++) p[i] = a.v[i]; }
+
+inline Float4 operator + (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] + b.v[i]; return r; }
+inline Float4 operator - (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] - b.v[i]; return r; }
+inline Float4 operator * (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] * b.v[i]; return r; }
+inline Float4 operator / (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] / b.v[i]; return r; }
+
+inline Float4 load_bytes4(const uint8_t* p) { return Float4 { { (float) p[0], (float) p[1], (float) p[2], (float) p[3] } }; }
+
+inline void store_bytes16(uint8_t* p, Float4 a, Float4 b, Float4 c, Float4 d)
+{
+    const Float4* lanes[4] = { &a, &b, &c, &d };
+    for (int i = 0; i < 16; i++)
+    {
+        int truncated = (int) lanes[i / 4]->v[i % 4];
+        p[i] = truncated < 0 ? 0 : truncated > 255 ? 255 : truncated;
+    }
+}
+
+inline void store_int4(int32_t* p, Float4 a) { for (int i = 0; i < 4; i++) p[i] = (int32_t) a.v[i]; }
+
+template <int x, int y, int z, int w> inline Float4 shuffle(Float4 a) { return Float4 { { a.v[x], a.v[y], a.v[z], a.v[w] } }; }
+
+inline Float4 min_float4 (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+inline Float4 max_float4 (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+
+// Scalar masks are stored as 1.0f (set) and 0.0f (clear)
+inline Float4 cmp_ge   (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] >= b.v[i]; return r; }
+inline Float4 cmp_gt   (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] >  b.v[i]; return r; }
+inline Float4 cmp_lt   (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] <  b.v[i]; return r; }
+inline Float4 mask_and (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] != 0.0f && b.v[i] != 0.0f; return r; }
+inline Float4 mask_or  (Float4 a, Float4 b) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = a.v[i] != 0.0f || b.v[i] != 0.0f; return r; }
+inline int    move_mask(Float4 a)           { int m = 0; for (int i = 0; i < 4; i++) m |= (a.v[i] != 0.0f) << i; return m; }
+
+#endif
@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Simd.h"
+#include "tgaimage.h"
+
+struct Pack;
+
+// Bytes per texel is the format's channel count
+enum TextureFormat { TEXTURE_R8 = 1, TEXTURE_RGBA8 = 4 };
+
+enum TextureFilter { FILTER_NEAREST, FILTER_BILINEAR, FILTER_TRILINEAR };
+
+// Tiled levels are 4x4 texel blocks, row-major inside a block and blocks row-major over the level,
+// an RGBA8 block is one 64 byte cache line. Edges are padded up to whole blocks.
+enum TextureLayout { TEXTURE_LINEAR, TEXTURE_TILED };
+
+const int TEXTURE_BLOCK_SHIFT = 2; // 4x4 blocks
+const int TEXTURE_BLOCK_MASK = (1 << TEXTURE_BLOCK_SHIFT) - 1;
+const size_t TEXTURE_ALIGNMENT = 64;
+
+// Enough for a 32768x32768 texture
+const int MAX_TEXTURE_LEVELS = 16;
+
+struct TextureLevel
+{
+    const uint8_t* data; // points either into storage or straight into a mapped pack file
+    int width, height;
+};
+
+/**
+ * 8-bit mipmapped texture, texels stay packed in memory and only become floats in registers when sampled.
+ *
+ * Level 0 is the full size texture, every next level is half the size (rounded down, at least 1)
+ * down to 1x1. Rows are stored bottom up (like Buffer), single channel textures sample as grey with full alpha.
+ */
+struct Texture
+{
+    TextureLevel levels[MAX_TEXTURE_LEVELS];
+    int level_count;
+    TextureFormat format;
+    TextureLayout layout;
+
+    std::vector<uint8_t> storage; // all levels back to back, empty for a texture that views a pack file
+
+    Texture() = default;
+    Texture(const Texture&) = delete; // views would point into the other texture's storage
+    Texture& operator = (const Texture&) = delete;
+};
+
+// Texel's position in its level's data, in texels, is the sum of a row part and a column part
+// NOTE: so a bilinear footprint takes 2 row and 2 column computations, not 4 full ones
+inline size_t get_texel_row_index(int y, int width, TextureLayout layout)
+{
+    if (layout == TEXTURE_LINEAR) return (size_t) y * width;
+
+    size_t blocks_per_row = (width + TEXTURE_BLOCK_MASK) >> TEXTURE_BLOCK_SHIFT;
+    return (((y >> TEXTURE_BLOCK_SHIFT) * blocks_per_row) << (2 * TEXTURE_BLOCK_SHIFT)) + ((y & TEXTURE_BLOCK_MASK) << TEXTURE_BLOCK_SHIFT);
+}
+
+inline size_t get_texel_column_index(int x, TextureLayout layout)
+{
+    if (layout == TEXTURE_LINEAR) return x;
+    return ((x >> TEXTURE_BLOCK_SHIFT) << (2 * TEXTURE_BLOCK_SHIFT)) + (x & TEXTURE_BLOCK_MASK);
+}
+
+inline size_t get_texel_index(int x, int y, int width, TextureLayout layout)
+{
+    return get_texel_row_index(y, width, layout) + get_texel_column_index(x, layout);
+}
+
+// Levels past level 0 are left zeroed, level_count is capped at the full chain
+void     init_texture         (int width, int height, TextureFormat format, TextureLayout layout, int level_count, Texture* texture);
+int      get_full_level_count (int width, int height);
+size_t   get_level_size       (int width, int height, TextureFormat format, TextureLayout layout);
+size_t   get_texture_size     (const Texture* texture);
+void     build_mip_levels     (Texture* texture);
+void     set_texture_layout   (TextureLayout layout, Texture* texture); // reorders the texels of every level
+uint8_t* get_writable_level   (int level, Texture* texture);            // for filling a texture made in code
+Texture* tga_image_to_texture (TGAImage& img); // tiled, with its full mip chain
+
+// Level of detail from screen space uv derivatives (uv change per pixel step in x and in y)
+float get_texture_lod (const Texture* texture, float du_dx, float dv_dx, float du_dy, float dv_dy);
+
+// uv will be clamped, returns rgba in 0 to 1
+Float4 sample_nearest   (float u, float v, int level, const Texture* texture);
+Float4 sample_bilinear  (float u, float v, int level, const Texture* texture);
+Float4 sample_trilinear (float u, float v, float lod, const Texture* texture);
+Float4 sample_texture   (float u, float v, float lod, TextureFilter filter, const Texture* texture);
+
+const size_t DEFAULT_TEXTURE_BUDGET = 256 << 20;
+
+struct TextureEntry
+{
+    std::string path;
+    Texture* texture;
+    int ref_count;
+    uint64_t last_release; // unreferenced textures are evicted least recently released first
+    bool is_owned;         // false for textures viewing a pack, those live as long as the pack
+};
+
+/**
+ * Textures shared by path, loaded on first acquire from the pack (when there is one) or the TGA file.
+ * A path that fails to load gets a 1x1 magenta texture instead, acquire never returns nullptr.
+ *
+ * Released textures stay loaded until loading another one would go over the budget. Textures still
+ * referenced are never evicted, so the budget can be exceeded when they alone take more than it.
+ */
+struct TextureManager
+{
+    std::vector<TextureEntry> entries;
+    Pack* pack;
+    size_t budget; // bytes of texels, 0 for no limit
+    size_t size;
+    uint64_t release_count;
+};
+
+void     init_texture_manager    (size_t budget, Pack* pack, TextureManager* manager);
+void     destroy_texture_manager (TextureManager* manager);
+void     set_texture_budget      (size_t budget, TextureManager* manager);
+Texture* acquire_texture         (const char* path, TextureManager* manager);
+Texture* add_texture             (const char* path, Texture* texture, TextureManager* manager); // made in code, owned by the manager from then on, acquired once
+void     release_texture         (Texture* texture, TextureManager* manager);
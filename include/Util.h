@@ -1,8 +1,18 @@
-float clampf(float f, float min, float max);
+#pragma once
+#include <cassert>
+
 float clampi(int i, int min, int max);
 float lerpf(float a, float b, float t);
-float maxf(float a, float b);
-float minf(float a, float b);
-int min_i(int a, int b);
-int max_i(int a, int b);
-float radians(float degree);
\ No newline at end of file
+float radians(float degree);
+
+// Inline, they run per pixel in the fused fragment stage and the rasterizers
+inline float clampf(float f, float min, float max)
+{
+    assert(min <= max);
+    return f < min ? min : f > max ? max : f;
+}
+
+inline float maxf(float a, float b) { return a > b ? a : b; }
+inline float minf(float a, float b) { return a < b ? a : b; }
+inline int min_i(int a, int b) { return a < b ? a : b; }
+inline int max_i(int a, int b) { return a > b ? a : b; }
@@ -0,0 +1,22 @@
+#pragma once
+#include "Mat.h"
+#include "Geometry.h"
+
+typedef unsigned short Outcode;
+const int MAX_OUTCODE_PLANES = 12;
+
+/**
+ * Batched vertex transform, structure-of-arrays in and out.
+ * 
+ * Transforms count positions by an affine model-view matrix (bottom row 0 0 0 1),
+ * and in the same pass computes each vertex's outcode: bit p is set when the vertex
+ * is not strictly inside plane p (distance <= epsilon), planes must be normalized.
+ * 
+ * Runs 8 vertices per instruction with AVX when the CPU has it.
+ */
+void transform_vertices(
+    const Mat4x4f& model_view, 
+    const float* x, const float* y, const float* z, int count,
+    const Plane* planes, int plane_count, float epsilon,
+    float* out_x, float* out_y, float* out_z, Outcode* outcodes
+);
@@ -1,7 +1,7 @@
 #include <SDL3/SDL.h>
 #include "Vec.h"
 
-enum KEY_CODES { KEY_A = 0, KEY_SPACE, KEY_ENTER, KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT, KEY_COUNT };
+enum KEY_CODES { KEY_A = 0, KEY_SPACE, KEY_ENTER, KEY_UP, KEY_DOWN, KEY_LEFT, KEY_RIGHT, KEY_P, KEY_COUNT };
 
 struct KeyState
 {
@@ -45,7 +45,7 @@ struct Window
 {
     SDL_Window* handle = nullptr;
     SDL_Surface* draw_surface = nullptr;
-    int* pixels = nullptr;
+    int* pixels = nullptr; // draw surface's, used when the window surface's format is not one present_pixels writes
     int width;
     int height;
     UserInput input;
@@ -53,5 +53,5 @@ struct Window
 
 void init_window(int width, int height);
 void resize_window(int width, int height);
-void blit_window(float* pixels);
+void blit_window(float* pixels, bool is_srgb = false); // is_srgb encodes linear pixels to sRGB on the way
 void poll_events();
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+#include <functional>
+
+// Worker index 0 is always the calling thread, pool threads are 1..count-1
+typedef std::function<void(int task, int worker)> ParallelTask;
+
+void init_worker_pool    (int thread_count);
+void destroy_worker_pool ();
+int  get_worker_count    ();
+void parallel_for        (int task_count, const ParallelTask& task);
+
+// NOTE: parallel_for is not re-entrant, tasks must not call it themselves
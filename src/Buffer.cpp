@@ -83,16 +83,24 @@ void clear_buffer(const float* clear, Buffer* buf)
     }
 }
 
-// buffer is left un-initialized
+// buffer is left un-initialized, only reallocated when it grows past its capacity
 void resize_buffer(int width, int height, Buffer* buf)
 {
-    if (!buf->data) delete[] buf->data;
-
-    buf->data = new float[width * height * buf->fpp];
+    reserve_buffer(width, height, buf);
     buf->width = width;
     buf->height = height;
 }
 
+// NOTE: one float of padding past the end, so SIMD code can load any element as 4 floats
+void reserve_buffer(int width, int height, Buffer* buf)
+{
+    if (width * height <= buf->capacity) return;
+
+    delete[] buf->data;
+    buf->data = new float[width * height * buf->fpp + 1];
+    buf->capacity = width * height;
+}
+
 void blit_buffer(Buffer* src, Buffer* target, float x_offset, float y_offset, float width_percent, float height_percent)
 {
     // NOTE: their seems to be bugs being caused by this function
@@ -120,6 +128,8 @@ void blit_buffer(Buffer* src, Buffer* target, float x_offset, float y_offset, fl
 
 void init_buffer(int width, int height, int fpp, Buffer* buf)
 {
+    buf->data = nullptr;
+    buf->capacity = 0;
     buf->fpp = fpp;
     resize_buffer(width, height, buf);
 }
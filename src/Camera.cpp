@@ -1,3 +1,4 @@
+#include <cmath>
 #include "Camera.h"
 
 Frustum get_frustum(Camera cam)
@@ -20,4 +21,15 @@ Frustum get_frustum(Camera cam)
     frustum.b = h/2.0f;
 
     return frustum;
-}
\ No newline at end of file
+}
+
+void set_orbit_camera(float yaw, float pitch, float radius, Camera* camera)
+{
+    camera->yaw = yaw;
+    camera->pitch = pitch;
+
+    camera->dir.x = sin(pitch) * sin(yaw);
+    camera->dir.y = cos(pitch);
+    camera->dir.z = sin(pitch) * cos(yaw);
+    camera->pos   = camera->dir * -radius;
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <vector>
+#include "Cull.h"
+#include "Simd.h"
+
+// View space bounds, structure-of-arrays, padded to a multiple of 4
+struct ViewBounds
+{
+    std::vector<float> center_x, center_y, center_z;
+    std::vector<float> radius;
+    std::vector<float> axis[3][3]; // axis[i] is box half-axis i, x y z components
+
+    void resize(int count)
+    {
+        center_x.resize(count);
+        center_y.resize(count);
+        center_z.resize(count);
+        radius.resize(count);
+        for (int i = 0; i < 3; i++)
+        {
+            for (int c = 0; c < 3; c++) axis[i][c].resize(count);
+        }
+    }
+};
+
+static void transform_bounds(const Mat4x4f& model_view, const BoundingVolume& bounds, int i, ViewBounds& view)
+{
+    Vec3f center = model_view * Vec4f(bounds.sphere_center, 1.0f);
+    Vec3f half_extents = (bounds.aabb_max - bounds.aabb_min) * 0.5f;
+
+    float max_scale = 0.0f;
+    for (int a = 0; a < 3; a++)
+    {
+        Vec3f col = model_view.get_col(a).xyz();
+        max_scale = std::max(max_scale, col.length());
+        for (int c = 0; c < 3; c++) view.axis[a][c][i] = col.raw[c] * half_extents.raw[a];
+    }
+
+    view.center_x[i] = center.x;
+    view.center_y[i] = center.y;
+    view.center_z[i] = center.z;
+    view.radius[i] = bounds.sphere_radius * max_scale;
+}
+
+static Float4 abs_float4(Float4 a)
+{
+    return max_float4(a, float4(0.0f) - a);
+}
+
+void cull_objects(
+    const Plane* planes, int plane_count, float epsilon,
+    const Mat4x4f* model_views, const BoundingVolume* bounds, int count,
+    CullResult* results
+)
+{
+    static ViewBounds view; // NOTE: only called from the render thread
+    int padded_count = (count + 3) & ~3;
+    view.resize(padded_count);
+    for (int i = 0; i < count; i++) transform_bounds(model_views[i], bounds[i], i, view);
+
+    // ROBUSTNESS: vertices are transformed with a different matrix product order, leave room for rounding
+    Float4 inside_margin = float4(2.0f * epsilon);
+    Float4 outside_margin = float4(-epsilon);
+
+    for (int i = 0; i < padded_count; i += 4)
+    {
+        Float4 center_x = load_float4(&view.center_x[i]);
+        Float4 center_y = load_float4(&view.center_y[i]);
+        Float4 center_z = load_float4(&view.center_z[i]);
+        Float4 sphere_radius = load_float4(&view.radius[i]);
+
+        int is_outside = 0, is_inside = 0xF;
+        for (int p = 0; p < plane_count; p++)
+        {
+            Float4 a = float4(planes[p].a), b = float4(planes[p].b), c = float4(planes[p].c);
+            Float4 distance = ((a * center_x + b * center_y) + c * center_z) + float4(planes[p].d);
+
+            // Box's extent along the plane normal
+            Float4 box_radius = float4(0.0f);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                Float4 projected = (a * load_float4(&view.axis[axis][0][i]) + b * load_float4(&view.axis[axis][1][i])) + c * load_float4(&view.axis[axis][2][i]);
+                box_radius = box_radius + abs_float4(projected);
+            }
+            Float4 radius = min_float4(sphere_radius, box_radius);
+
+            is_outside |= move_mask(cmp_lt(distance + radius, outside_margin));
+            is_inside  &= move_mask(cmp_gt(distance - radius, inside_margin));
+        }
+
+        for (int lane = 0; lane < 4 && i + lane < count; lane++)
+        {
+            if      (is_outside & (1 << lane)) results[i + lane] = CULL_OUTSIDE;
+            else if (is_inside  & (1 << lane)) results[i + lane] = CULL_INSIDE;
+            else                               results[i + lane] = CULL_INTERSECTING;
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include <cmath>
+#include "DynamicResolution.h"
+#include "Util.h"
+
+const float SMOOTHING = 0.2f;           // weight of the newest frame in the average
+const float TARGET_RATIO = 0.9f;        // a change aims for this much of the budget
+const float LOW_RATIO = 0.75f;          // below this much of the budget the scale may go up
+const float SPIKE_RATIO = 1.5f;         // one frame this far over the budget drops the scale right away
+const float MAX_SCALE_UP = 1.1f;        // per change, going up is gradual
+const float SCALE_STEP = 1.0f / 64.0f;  // scales are snapped to steps, tiny changes are not worth a resize
+const int FRAMES_OVER_TO_DROP = 3;
+const int FRAMES_UNDER_TO_RAISE = 30;
+
+void init_resolution_controller(float budget_ms, float min_scale, float max_scale, ResolutionController* controller)
+{
+    controller->budget_ms = budget_ms;
+    controller->min_scale = min_scale;
+    controller->max_scale = max_scale;
+    controller->scale = max_scale;
+    controller->smoothed_ms = 0.0f;
+    controller->frames_over = 0;
+    controller->frames_under = 0;
+}
+
+// Scale that would have taken the target time, had render_ms been spent at the current one
+static float get_target_scale(float render_ms, const ResolutionController* controller)
+{
+    return controller->scale * std::sqrt(TARGET_RATIO * controller->budget_ms / maxf(render_ms, 0.001f));
+}
+
+static bool set_scale(float scale, ResolutionController* controller)
+{
+    scale = clampf(std::round(scale / SCALE_STEP) * SCALE_STEP, controller->min_scale, controller->max_scale);
+    controller->frames_over = 0;
+    controller->frames_under = 0;
+    if (scale == controller->scale) return false;
+
+    // Average carries over as if the past frames had been rendered at the new scale
+    float ratio = scale / controller->scale;
+    controller->smoothed_ms *= ratio * ratio;
+    controller->scale = scale;
+    return true;
+}
+
+bool update_resolution_controller(float render_ms, ResolutionController* controller)
+{
+    if (controller->smoothed_ms == 0.0f) controller->smoothed_ms = render_ms;
+    else                                 controller->smoothed_ms = lerpf(controller->smoothed_ms, render_ms, SMOOTHING);
+
+    if (render_ms > SPIKE_RATIO * controller->budget_ms)
+    {
+        controller->smoothed_ms = render_ms;
+        return set_scale(get_target_scale(render_ms, controller), controller);
+    }
+
+    if (controller->smoothed_ms > controller->budget_ms)
+    {
+        controller->frames_under = 0;
+        if (++controller->frames_over >= FRAMES_OVER_TO_DROP) return set_scale(get_target_scale(controller->smoothed_ms, controller), controller);
+    }
+    else if (controller->smoothed_ms < LOW_RATIO * controller->budget_ms)
+    {
+        controller->frames_over = 0;
+        if (++controller->frames_under >= FRAMES_UNDER_TO_RAISE)
+        {
+            float scale = minf(get_target_scale(controller->smoothed_ms, controller), controller->scale * MAX_SCALE_UP);
+            return set_scale(scale, controller);
+        }
+    }
+    else
+    {
+        controller->frames_over = 0;
+        controller->frames_under = 0;
+    }
+
+    return false;
+}
@@ -1,5 +1,6 @@
 #include "Geometry.h"
 #include <cassert>
+#include <algorithm>
 
 
 std::vector<Plane> get_frustum_planes(Frustum fru)
@@ -23,6 +24,38 @@ std::vector<Plane> get_frustum_planes(Frustum fru)
     return planes;
 }
 
+Plane normalized_plane(Plane plane)
+{
+    float one_over_length = 1.0f / Vec3f(plane.a, plane.b, plane.c).length();
+    return Plane { plane.a * one_over_length, plane.b * one_over_length, plane.c * one_over_length, plane.d * one_over_length };
+}
+
+BoundingVolume get_bounding_volume(const Vec3f* points, int count)
+{
+    BoundingVolume bounds { Vec3f(0.0f), Vec3f(0.0f), Vec3f(0.0f), 0.0f };
+    if (count == 0) return bounds;
+
+    bounds.aabb_min = points[0];
+    bounds.aabb_max = points[0];
+    for (int i = 1; i < count; i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            bounds.aabb_min.raw[axis] = std::min(bounds.aabb_min.raw[axis], points[i].raw[axis]);
+            bounds.aabb_max.raw[axis] = std::max(bounds.aabb_max.raw[axis], points[i].raw[axis]);
+        }
+    }
+
+    // NOTE: tighter than the box's half diagonal whenever the points don't reach the box corners
+    bounds.sphere_center = (bounds.aabb_min + bounds.aabb_max) * 0.5f;
+    for (int i = 0; i < count; i++)
+    {
+        bounds.sphere_radius = std::max(bounds.sphere_radius, (points[i] - bounds.sphere_center).length());
+    }
+
+    return bounds;
+}
+
 void cull_polygon(const std::vector<Vertex>& polygon, Plane plane, std::vector<Vertex>& in, std::vector<Vertex>& out, float epsilon)
 {
     // TODO: maybe let user handle normalization, since sometimes user will already pass in normalized plane
@@ -74,6 +107,69 @@ void cull_polygon(const std::vector<Vertex>& polygon, Plane plane, std::vector<V
     }
 }
 
+/**
+ * Same rules as cull_polygon (vertices within epsilon of a plane are kept, crossings get
+ * an interpolated vertex) but without allocating: clips in place against every plane whose
+ * bit is set in plane_mask, ping-ponging between the polygon and one stack buffer.
+ * 
+ * ASSUMPTION: planes are normalized
+ * ASSUMPTION: polygon.count + number of planes clipped against <= MAX_CLIP_VERTICES
+ */
+void clip_polygon(ClipPolygon& polygon, const Plane* planes, int plane_count, unsigned int plane_mask, float epsilon)
+{
+    ClipPolygon scratch;
+    ClipPolygon* src = &polygon;
+    ClipPolygon* dst = &scratch;
+    float deltas[MAX_CLIP_VERTICES];
+
+    for (int p = 0; p < plane_count && src->count > 0; p++)
+    {
+        if (!(plane_mask & (1 << p))) continue;
+
+        Vec3f norm (planes[p].a, planes[p].b, planes[p].c);
+        float d = planes[p].d;
+        for (int i = 0; i < src->count; i++) deltas[i] = (norm * src->vertices[i].cull) + d;
+
+        dst->count = 0;
+        for (int i = 0; i < src->count; i++)
+        {
+            int next = (i + 1) == src->count ? 0 : i + 1;
+            const Vertex& cur = src->vertices[i];
+            float cur_delta = deltas[i], next_delta = deltas[next];
+
+            bool is_cur_in = cur_delta > epsilon;
+            bool is_cur_on = std::abs(cur_delta) <= epsilon;
+            bool is_next_in = next_delta > epsilon;
+            bool is_next_on = std::abs(next_delta) <= epsilon;
+
+            if (is_cur_in || is_cur_on)
+            {
+                assert(dst->count < MAX_CLIP_VERTICES);
+                dst->vertices[dst->count++] = cur;
+            }
+
+            if (!is_cur_on && !is_next_on && is_cur_in != is_next_in)
+            {
+                const Vertex& other = src->vertices[next];
+                float total_length = (other.cull - cur.cull).length();
+                Vec3f dir = (other.cull - cur.cull) * (1.0f/total_length);
+                float length = std::abs(cur_delta / (dir * norm));
+
+                assert(dst->count < MAX_CLIP_VERTICES);
+                dst->vertices[dst->count++] = interpolate_vertex(cur, other, length/total_length);
+            }
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != &polygon)
+    {
+        for (int i = 0; i < src->count; i++) polygon.vertices[i] = src->vertices[i];
+        polygon.count = src->count;
+    }
+}
+
 Vec3f reflect_vector(const Vec3f& surface_normal, const Vec3f& vector)
 {
     // CREDIT: https://math.stackexchange.com/questions/13261/how-to-get-a-reflection-vector
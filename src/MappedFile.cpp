@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// NOTE: an empty file maps fine, data is nullptr and size 0
+#ifdef _WIN32
+
+bool map_file(const char* filename, MappedFile* file, bool is_copy_on_write)
+{
+    file->data = nullptr;
+    file->size = 0;
+    file->handle = nullptr;
+
+    HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size)) { CloseHandle(handle); return false; }
+    if (size.QuadPart == 0) { CloseHandle(handle); return true; }
+
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, is_copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (!mapping) return false;
+
+    file->data = (const char*) MapViewOfFile(mapping, is_copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    if (!file->data) { CloseHandle(mapping); return false; }
+    file->size = (size_t) size.QuadPart;
+    file->handle = mapping;
+    return true;
+}
+
+void unmap_file(MappedFile* file)
+{
+    if (file->data) UnmapViewOfFile(file->data);
+    if (file->handle) CloseHandle((HANDLE) file->handle);
+    file->data = nullptr;
+    file->size = 0;
+    file->handle = nullptr;
+}
+
+#else
+
+bool map_file(const char* filename, MappedFile* file, bool is_copy_on_write)
+{
+    file->data = nullptr;
+    file->size = 0;
+    file->handle = nullptr;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) { close(fd); return false; }
+    if (info.st_size == 0) { close(fd); return true; }
+
+    void* data = mmap(nullptr, info.st_size, is_copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // mapping stays valid
+    if (data == MAP_FAILED) return false;
+
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    file->data = (const char*) data;
+    file->size = info.st_size;
+    return true;
+}
+
+void unmap_file(MappedFile* file)
+{
+    if (file->data) munmap((void*) file->data, file->size);
+    file->data = nullptr;
+    file->size = 0;
+}
+
+#endif
@@ -210,12 +210,16 @@ Vec4f Mat4x4f::operator*(const Vec4f& right) const
 
 Mat4x4f Mat4x4f::operator*(const Mat4x4f& right) const
 {
-    return Mat4x4f(
-        (*this) * right.get_col(0), 
-        (*this) * right.get_col(1), 
-        (*this) * right.get_col(2), 
-        (*this) * right.get_col(3)
-    );
+    // NOTE: indexes rows directly instead of building columns with get_col, same summation order
+    Mat4x4f result;
+    for (int r = 0; r < 4; r++)
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            result.mat[r][c] = (mat[r][0] * right.mat[0][c]) + (mat[r][1] * right.mat[1][c]) + (mat[r][2] * right.mat[2][c]) + (mat[r][3] * right.mat[3][c]);
+        }
+    }
+    return result;
 }
 
 Vec4f Mat4x4f::get_col(int i) const
@@ -1,53 +1,374 @@
 #include <iostream>
-#include <string>
-#include <fstream>
-#include <sstream>
 #include <vector>
+#include <cstring>
+#include <algorithm>
+#include <charconv>
+#include <unordered_map>
 #include "Mesh.h"
+#include "MeshOptimize.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
 
-Mesh::Mesh(const char *filename) : vertices(), faces()
+/**
+ * PROCESS: (OBJ loading)
+ * 
+ * map the file, split it into chunks at line boundaries
+ * 
+ * count, in parallel over chunks
+ *      count v, vt, vn and f lines of the chunk
+ *      prefix sums give every chunk its first vertex, uv and normal, so arrays are sized up front
+ *      and negative (relative) indices can be resolved while parsing
+ * 
+ * parse, in parallel over chunks
+ *      positions, uvs and normals go straight into their place in the attribute arrays
+ *      faces go into the chunk's own corner list
+ * 
+ * index, walking the chunks in order
+ *      every unique (position, uv, normal) corner becomes one mesh vertex
+ *      faces are fan triangulated into the index buffer
+ * 
+ * reorder triangles for vertex locality and less overdraw (see MeshOptimize.h)
+ * 
+ * Supports faces of the forms v, v/vt, v//vn and v/vt/vn, with negative indices.
+ * Everything else (o, g, s, usemtl, mtllib, comments) is skipped.
+ */
+
+const size_t MIN_CHUNK_SIZE = 1 << 16;
+
+// Indices into the file's attribute arrays, -1 when the face didn't give that attribute
+struct FaceCorner { int position, uv, normal; };
+
+struct FaceCornerHash
 {
-    std::ifstream in;
-    in.open (filename, std::ifstream::in);
-    if (in.fail()) 
+    size_t operator()(const FaceCorner& c) const
     {
-        std::cerr << "Error:: could not open model file " << filename << '\n';
-        return;
+        uint64_t h = (uint64_t) (uint32_t) c.position * 0x9E3779B97F4A7C15ull;
+        h ^= ((uint64_t) (uint32_t) c.uv + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+        h ^= ((uint64_t) (uint32_t) c.normal + 0x165667B19E3779F9ull) * 0x27D4EB2F165667C5ull;
+        return h ^ (h >> 29);
+    }
+};
+
+struct FaceCornerEqual
+{
+    bool operator()(const FaceCorner& a, const FaceCorner& b) const
+    {
+        return a.position == b.position && a.uv == b.uv && a.normal == b.normal;
     }
-    std::string line;
-    while (!in.eof())
+};
+
+// Attributes as the file lists them, before they are merged into mesh vertices
+struct ObjAttributes
+{
+    std::vector<Vec3f> positions;
+    std::vector<Vec2f> uvs;
+    std::vector<Vec3f> normals;
+};
+
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+
+    int vertex_count, uv_count, normal_count, face_count;
+    int first_vertex, first_uv, first_normal;
+
+    std::vector<FaceCorner> corners;
+    std::vector<int> face_sizes;
+    int dropped_face_count; // faces with an out of range index, left out
+};
+
+enum ObjLine { OBJ_VERTEX, OBJ_UV, OBJ_NORMAL, OBJ_FACE, OBJ_OTHER };
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Line type, and where its data starts
+static ObjLine get_line_type(const char* p, const char* line_end, const char** data)
+{
+    if (line_end - p < 2) return OBJ_OTHER;
+
+    ObjLine type = OBJ_OTHER;
+    if      (p[0] == 'v' && is_space(p[1])) { type = OBJ_VERTEX; *data = p + 1; }
+    else if (p[0] == 'f' && is_space(p[1])) { type = OBJ_FACE;   *data = p + 1; }
+    else if (p[0] == 'v' && line_end - p > 2 && is_space(p[2]))
     {
-        std::getline(in, line);
-        std::istringstream iss(line.c_str());
-        char trash;
-        if (!line.compare(0, 2, "v "))
+        if      (p[1] == 't') { type = OBJ_UV;     *data = p + 2; }
+        else if (p[1] == 'n') { type = OBJ_NORMAL; *data = p + 2; }
+    }
+    return type;
+}
+
+static const char* find_line_end(const char* p, const char* end)
+{
+    const char* line_end = (const char*) memchr(p, '\n', end - p);
+    return line_end ? line_end : end;
+}
+
+static const char* parse_float(const char* p, const char* end, float& value)
+{
+    while (p < end && is_space(*p)) p++;
+    if (p < end && *p == '+') p++;
+
+    value = 0.0f;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ptr;
+}
+
+// OBJ indices are 1-based, negative ones count back from the last element so far
+static int resolve_index(int index, int count_so_far, int total, bool& is_bad)
+{
+    int resolved = index > 0 ? index - 1 : count_so_far + index;
+    if (index == 0 || resolved < 0 || resolved >= total) is_bad = true;
+    return resolved;
+}
+
+static void count_chunk(ObjChunk& chunk)
+{
+    chunk.vertex_count = chunk.uv_count = chunk.normal_count = chunk.face_count = 0;
+    for (const char* p = chunk.begin; p < chunk.end; )
+    {
+        const char* line_end = find_line_end(p, chunk.end);
+        const char* data;
+        switch (get_line_type(p, line_end, &data))
+        {
+            case OBJ_VERTEX: chunk.vertex_count++; break;
+            case OBJ_UV:     chunk.uv_count++;     break;
+            case OBJ_NORMAL: chunk.normal_count++; break;
+            case OBJ_FACE:   chunk.face_count++;   break;
+            default: break;
+        }
+        p = line_end + 1;
+    }
+}
+
+static void parse_chunk(ObjChunk& chunk, ObjAttributes& attributes)
+{
+    int vertex = chunk.first_vertex, uv = chunk.first_uv, normal = chunk.first_normal;
+    int vertex_total = attributes.positions.size(), uv_total = attributes.uvs.size(), normal_total = attributes.normals.size();
+
+    chunk.corners.clear();
+    chunk.corners.reserve(chunk.face_count * 3);
+    chunk.face_sizes.clear();
+    chunk.face_sizes.reserve(chunk.face_count);
+    chunk.dropped_face_count = 0;
+
+    for (const char* p = chunk.begin; p < chunk.end; )
+    {
+        const char* line_end = find_line_end(p, chunk.end);
+        const char* data;
+        ObjLine type = get_line_type(p, line_end, &data);
+
+        if (type == OBJ_VERTEX || type == OBJ_NORMAL)
         {
-            iss >> trash;
             Vec3f v;
-            for (int i=0;i<3;i++) iss >> v.raw[i];
-            vertices.push_back(v);
+            for (int i = 0; i < 3; i++) data = parse_float(data, line_end, v.raw[i]);
+            if (type == OBJ_VERTEX) attributes.positions[vertex++] = v;
+            else                    attributes.normals[normal++] = v;
         }
-        else if (!line.compare(0, 2, "vt"))
+        else if (type == OBJ_UV)
         {
-            iss >> trash; iss >> trash;
-            Vec2f uv;
-            for (int i=0;i<2;i++) iss >> uv.raw[i];
-            uvs.push_back(uv);
+            Vec2f t;
+            for (int i = 0; i < 2; i++) data = parse_float(data, line_end, t.raw[i]);
+            attributes.uvs[uv++] = t;
+        }
+        else if (type == OBJ_FACE)
+        {
+            int size = 0;
+            bool has_bad_index = false;
+            const char* q = data;
+            while (true)
+            {
+                while (q < line_end && is_space(*q)) q++;
+                if (q >= line_end) break;
+
+                int index;
+                std::from_chars_result result = std::from_chars(q, line_end, index);
+                if (result.ec != std::errc()) break; // ROBUSTNESS: trailing junk ends the face
+
+                FaceCorner corner { resolve_index(index, vertex, vertex_total, has_bad_index), -1, -1 };
+                q = result.ptr;
+                if (q < line_end && *q == '/')
+                {
+                    q++;
+                    if (q < line_end && *q != '/')
+                    {
+                        result = std::from_chars(q, line_end, index);
+                        if (result.ec == std::errc()) corner.uv = resolve_index(index, uv, uv_total, has_bad_index);
+                        q = result.ptr;
+                    }
+                    if (q < line_end && *q == '/')
+                    {
+                        q++;
+                        result = std::from_chars(q, line_end, index);
+                        if (result.ec == std::errc()) corner.normal = resolve_index(index, normal, normal_total, has_bad_index);
+                        q = result.ptr;
+                    }
+                }
+                while (q < line_end && !is_space(*q)) q++; // ROBUSTNESS: skip whatever is left of a malformed corner
+
+                chunk.corners.push_back(corner);
+                size++;
+            }
+
+            if (has_bad_index)
+            {
+                chunk.corners.resize(chunk.corners.size() - size);
+                chunk.dropped_face_count++;
+            }
+            else chunk.face_sizes.push_back(size);
         }
-        else if (!line.compare(0, 2, "f "))
+
+        p = line_end + 1;
+    }
+}
+
+/**
+ * Merges corners into unique vertices and fan triangulates faces, chunk by chunk in file order.
+ * 
+ * Normals are only kept when every corner has one, uvs default to (0, 0).
+ */
+static void build_indexed_mesh(const std::vector<ObjChunk>& chunks, const ObjAttributes& attributes, int corner_count, int face_count, MeshStorage& storage)
+{
+    bool has_normals = !attributes.normals.empty();
+    for (int c = 0; c < chunks.size() && has_normals; c++)
+    {
+        for (int i = 0; i < chunks[c].corners.size(); i++) has_normals = has_normals && chunks[c].corners[i].normal >= 0;
+    }
+
+    std::unordered_map<FaceCorner, uint32_t, FaceCornerHash, FaceCornerEqual> vertex_indices;
+    vertex_indices.reserve(corner_count);
+    storage.vertices.reserve(corner_count);
+    storage.uvs.reserve(corner_count);
+    if (has_normals) storage.normals.reserve(corner_count);
+    storage.indices.reserve(std::max(0, corner_count - 2 * face_count) * 3); // exact for faces of 3 or more corners
+
+    std::vector<uint32_t> face;
+    for (int c = 0; c < chunks.size(); c++)
+    {
+        const ObjChunk& chunk = chunks[c];
+        const FaceCorner* corner = chunk.corners.data();
+        for (int f = 0; f < chunk.face_sizes.size(); corner += chunk.face_sizes[f], f++)
         {
-            iss >> trash;
-            
-            std::vector<int> f;
-            int v_idx, uv_idx;
-            while (iss >> v_idx >> trash >> uv_idx)
+            face.clear();
+            for (int i = 0; i < chunk.face_sizes[f]; i++)
+            {
+                FaceCorner key = corner[i];
+                if (!has_normals) key.normal = -1;
+
+                auto inserted = vertex_indices.insert({ key, (uint32_t) storage.vertices.size() });
+                if (inserted.second)
+                {
+                    storage.vertices.push_back(attributes.positions[key.position]);
+                    storage.uvs.push_back(key.uv >= 0 ? attributes.uvs[key.uv] : Vec2f(0.0f, 0.0f));
+                    if (has_normals) storage.normals.push_back(attributes.normals[key.normal]);
+                }
+                face.push_back(inserted.first->second);
+            }
+
+            for (int i = 1; i + 1 < face.size(); i++)
             {
-                v_idx--;
-                uv_idx--;
-                f.push_back(v_idx);
-                f.push_back(uv_idx);
+                storage.indices.push_back(face[0]);
+                storage.indices.push_back(face[i]);
+                storage.indices.push_back(face[i + 1]);
             }
-            faces.push_back(f);
         }
     }
+}
+
+Mesh::Mesh() : storage(), is_loaded(true)
+{
+    update_from_storage();
+}
+
+Mesh::Mesh(const char *filename, bool is_reordered) : Mesh()
+{
+    MappedFile file;
+    if (!map_file(filename, &file)) 
+    {
+        std::cerr << "Error:: could not open model file " << filename << '\n';
+        is_loaded = false;
+        return;
+    }
+
+    // Chunks end right after a newline, so no line is split between two chunks
+    int chunk_count = std::max<size_t>(1, std::min<size_t>(get_worker_count() * 4, file.size / MIN_CHUNK_SIZE));
+    std::vector<ObjChunk> chunks (chunk_count);
+    const char* file_end = file.data + file.size;
+    const char* p = file.data;
+    for (int c = 0; c < chunk_count; c++)
+    {
+        const char* end = c == chunk_count - 1 ? file_end : file.data + (file.size * (c + 1)) / chunk_count;
+        if (end < p) end = p;
+        if (end < file_end) end = find_line_end(end, file_end) + 1;
+        if (end > file_end) end = file_end;
+
+        chunks[c].begin = p;
+        chunks[c].end = end;
+        p = end;
+    }
+
+    parallel_for(chunk_count, [&](int c, int) { count_chunk(chunks[c]); });
+
+    int vertex_count = 0, uv_count = 0, normal_count = 0, face_count = 0;
+    for (int c = 0; c < chunk_count; c++)
+    {
+        chunks[c].first_vertex = vertex_count;
+        chunks[c].first_uv = uv_count;
+        chunks[c].first_normal = normal_count;
+        vertex_count += chunks[c].vertex_count;
+        uv_count += chunks[c].uv_count;
+        normal_count += chunks[c].normal_count;
+        face_count += chunks[c].face_count;
+    }
+    ObjAttributes attributes;
+    attributes.positions.resize(vertex_count);
+    attributes.uvs.resize(uv_count);
+    attributes.normals.resize(normal_count);
+
+    parallel_for(chunk_count, [&](int c, int) { parse_chunk(chunks[c], attributes); });
+    unmap_file(&file);
+
+    int corner_count = 0, dropped_face_count = 0;
+    for (int c = 0; c < chunk_count; c++)
+    {
+        corner_count += chunks[c].corners.size();
+        dropped_face_count += chunks[c].dropped_face_count;
+    }
+
+    if (dropped_face_count > 0)
+    {
+        std::cerr << "Error:: model file " << filename << " has " << dropped_face_count << " faces with out of range indices, those faces dropped\n";
+    }
+    build_indexed_mesh(chunks, attributes, corner_count, face_count - dropped_face_count, storage);
+    if (is_reordered) optimize_triangle_order(storage.indices.data(), storage.indices.size() / 3, storage.vertices.data(), storage.vertices.size());
+
+    update_from_storage();
+}
+
+// Rebuilds the structure-of-arrays positions and the bounds, and points the views at storage
+void Mesh::update_from_storage()
+{
+    int count = storage.vertices.size();
+    storage.positions_x.resize(count);
+    storage.positions_y.resize(count);
+    storage.positions_z.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        storage.positions_x[i] = storage.vertices[i].x;
+        storage.positions_y[i] = storage.vertices[i].y;
+        storage.positions_z[i] = storage.vertices[i].z;
+    }
+
+    vertices = storage.vertices.data(); vertex_count   = count;
+    uvs      = storage.uvs.data();
+    normals  = storage.normals.data();  normal_count   = storage.normals.size();
+    indices  = storage.indices.data();  triangle_count = storage.indices.size() / 3;
+    positions_x = storage.positions_x.data();
+    positions_y = storage.positions_y.data();
+    positions_z = storage.positions_z.data();
+
+    bounds = get_bounding_volume(vertices, vertex_count);
 }
\ No newline at end of file
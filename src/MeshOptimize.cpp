@@ -0,0 +1,304 @@
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "MeshOptimize.h"
+#include "Geometry.h"
+
+/**
+ * PROCESS: (triangle reordering)
+ *
+ * tipsify, for vertex locality
+ *      fan out every not yet emitted triangle around the current vertex
+ *      next fanning vertex is the candidate that stays in the cache longest while its
+ *      remaining triangles are emitted, or a dead end when no candidate fits
+ *      dead ends pick a recently used vertex with triangles left, else the next one in index order
+ *
+ * cluster
+ *      hard boundaries at dead ends, the cache is cold there anyway
+ *      soft boundaries wherever the cluster's own ACMR drops under CLUSTER_ACMR_SCALE times
+ *      the whole mesh's, so cutting there costs little locality
+ *
+ * sort clusters, for less overdraw
+ *      outward facing clusters far from the mesh center tend to occlude the rest, they go first
+ */
+
+// Cuts more clusters the higher it is, at the cost of more cache misses at each cut
+const float CLUSTER_ACMR_SCALE = 0.75f;
+
+struct TriangleCluster
+{
+    int first, last; // triangle range in the tipsify order
+    float sort_key;
+};
+
+static int get_next_vertex(
+    const std::vector<uint32_t>& candidates, const std::vector<int>& live_counts, const std::vector<int>& cache_times,
+    int timestamp, std::vector<uint32_t>& dead_ends, int& cursor, int vertex_count, bool& is_dead_end
+)
+{
+    int best = -1, best_priority = -1;
+    for (int i = 0; i < candidates.size(); i++)
+    {
+        int v = candidates[i];
+        if (live_counts[v] <= 0) continue;
+
+        // Only counts if fanning v leaves its own triangles' vertices in the cache, older is better
+        int priority = 0;
+        if (timestamp - cache_times[v] + 2 * live_counts[v] <= VERTEX_CACHE_SIZE) priority = timestamp - cache_times[v];
+        if (priority > best_priority)
+        {
+            best_priority = priority;
+            best = v;
+        }
+    }
+    is_dead_end = best < 0;
+    if (best >= 0) return best;
+
+    while (!dead_ends.empty())
+    {
+        int v = dead_ends.back();
+        dead_ends.pop_back();
+        if (live_counts[v] > 0) return v;
+    }
+    for (; cursor < vertex_count; cursor++)
+    {
+        if (live_counts[cursor] > 0) return cursor++;
+    }
+    return -1;
+}
+
+// Triangle order, and the starts of the runs between dead ends
+static void tipsify(const uint32_t* indices, int triangle_count, int vertex_count, std::vector<int>& order, std::vector<int>& hard_boundaries)
+{
+    // Vertex to triangle adjacency, as offsets into one flat list
+    std::vector<int> live_counts (vertex_count, 0);
+    for (int i = 0; i < triangle_count * 3; i++) live_counts[indices[i]]++;
+
+    std::vector<int> adjacency_starts (vertex_count + 1, 0);
+    for (int v = 0; v < vertex_count; v++) adjacency_starts[v + 1] = adjacency_starts[v] + live_counts[v];
+    std::vector<int> adjacency (triangle_count * 3);
+    std::vector<int> fill (adjacency_starts.begin(), adjacency_starts.end() - 1);
+    for (int i = 0; i < triangle_count * 3; i++) adjacency[fill[indices[i]]++] = i / 3;
+
+    // NOTE: timestamps start past the cache size, so every vertex starts out of the cache
+    std::vector<int> cache_times (vertex_count, 0);
+    int timestamp = VERTEX_CACHE_SIZE + 1;
+    std::vector<bool> is_emitted (triangle_count, false);
+    std::vector<uint32_t> dead_ends, candidates;
+    order.clear();
+    order.reserve(triangle_count);
+    hard_boundaries.clear();
+
+    int cursor = 0;
+    bool is_dead_end = true;
+    int fanning = triangle_count > 0 ? indices[0] : -1;
+    while (fanning >= 0)
+    {
+        if (is_dead_end) hard_boundaries.push_back(order.size());
+
+        candidates.clear();
+        for (int a = adjacency_starts[fanning]; a < adjacency_starts[fanning + 1]; a++)
+        {
+            int t = adjacency[a];
+            if (is_emitted[t]) continue;
+
+            for (int i = 0; i < 3; i++)
+            {
+                uint32_t v = indices[t * 3 + i];
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                live_counts[v]--;
+                if (timestamp - cache_times[v] > VERTEX_CACHE_SIZE) cache_times[v] = timestamp++;
+            }
+            is_emitted[t] = true;
+            order.push_back(t);
+        }
+
+        fanning = get_next_vertex(candidates, live_counts, cache_times, timestamp, dead_ends, cursor, vertex_count, is_dead_end);
+    }
+}
+
+// Cache misses of one triangle against a FIFO cache, cache_times holds insertion times
+static int get_cache_misses(const uint32_t* triangle, std::vector<int>& cache_times, int& timestamp, int cache_size)
+{
+    int misses = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        uint32_t v = triangle[i];
+        if (timestamp - cache_times[v] > cache_size)
+        {
+            cache_times[v] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+void optimize_triangle_order(uint32_t* indices, int triangle_count, const Vec3f* vertices, int vertex_count)
+{
+    if (triangle_count < 2) return;
+
+    std::vector<int> order, hard_boundaries;
+    tipsify(indices, triangle_count, vertex_count, order, hard_boundaries);
+    hard_boundaries.push_back(triangle_count);
+
+    std::vector<uint32_t> reordered (triangle_count * 3);
+    for (int i = 0; i < triangle_count; i++)
+    {
+        for (int j = 0; j < 3; j++) reordered[i * 3 + j] = indices[order[i] * 3 + j];
+    }
+    float target_acmr = get_acmr(reordered.data(), triangle_count, vertex_count) * CLUSTER_ACMR_SCALE;
+
+    // Soft boundaries, each cluster's cache simulation starts cold like the cluster will after sorting
+    std::vector<TriangleCluster> clusters;
+    std::vector<int> cache_times (vertex_count, 0);
+    int timestamp = VERTEX_CACHE_SIZE + 1;
+    for (int h = 0; h + 1 < hard_boundaries.size(); h++)
+    {
+        int first = hard_boundaries[h], misses = 0;
+        timestamp += VERTEX_CACHE_SIZE + 1;
+        for (int t = hard_boundaries[h]; t < hard_boundaries[h + 1]; t++)
+        {
+            misses += get_cache_misses(&reordered[t * 3], cache_times, timestamp, VERTEX_CACHE_SIZE);
+            bool is_last = t + 1 == hard_boundaries[h + 1];
+            if (is_last || misses <= target_acmr * (t - first + 1))
+            {
+                clusters.push_back({ first, t, 0.0f });
+                first = t + 1;
+                misses = 0;
+                timestamp += VERTEX_CACHE_SIZE + 1;
+            }
+        }
+    }
+
+    // Area weighted centroids and normals, the cross product's length is twice the area
+    Vec3f mesh_center (0.0f, 0.0f, 0.0f);
+    float mesh_area = 0.0f;
+    std::vector<Vec3f> cluster_centers (clusters.size()), cluster_normals (clusters.size());
+    for (int c = 0; c < clusters.size(); c++)
+    {
+        Vec3f center (0.0f, 0.0f, 0.0f), normal (0.0f, 0.0f, 0.0f);
+        float area = 0.0f;
+        for (int t = clusters[c].first; t <= clusters[c].last; t++)
+        {
+            const Vec3f& a = vertices[reordered[t * 3]];
+            const Vec3f& b = vertices[reordered[t * 3 + 1]];
+            const Vec3f& d = vertices[reordered[t * 3 + 2]];
+            Vec3f cross = (b - a) ^ (d - a);
+            float triangle_area = cross.length();
+            center = center + (a + b + d) * (triangle_area / 3.0f);
+            normal = normal + cross;
+            area += triangle_area;
+        }
+        mesh_center = mesh_center + center;
+        mesh_area += area;
+        cluster_centers[c] = area > 0.0f ? center * (1.0f / area) : vertices[reordered[clusters[c].first * 3]];
+        cluster_normals[c] = normal;
+    }
+    if (mesh_area > 0.0f) mesh_center = mesh_center * (1.0f / mesh_area);
+
+    for (int c = 0; c < clusters.size(); c++)
+    {
+        float normal_length = cluster_normals[c].length();
+        clusters[c].sort_key = normal_length > 0.0f ? ((cluster_centers[c] - mesh_center) * cluster_normals[c]) / normal_length : 0.0f;
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b) { return a.sort_key > b.sort_key; });
+
+    uint32_t* out = indices;
+    for (int c = 0; c < clusters.size(); c++)
+    {
+        for (int t = clusters[c].first; t <= clusters[c].last; t++)
+        {
+            for (int j = 0; j < 3; j++) *out++ = reordered[t * 3 + j];
+        }
+    }
+}
+
+float get_acmr(const uint32_t* indices, int triangle_count, int vertex_count, int cache_size)
+{
+    if (triangle_count == 0) return 0.0f;
+
+    std::vector<int> cache_times (vertex_count, 0);
+    int timestamp = cache_size + 1, misses = 0;
+    for (int t = 0; t < triangle_count; t++) misses += get_cache_misses(indices + t * 3, cache_times, timestamp, cache_size);
+    return (float) misses / triangle_count;
+}
+
+// Points spread evenly over a sphere, on a golden angle spiral
+static Vec3f get_view_direction(int i, int count)
+{
+    float y = 1.0f - 2.0f * (i + 0.5f) / count;
+    float radius = std::sqrt(std::max(0.0f, 1.0f - y * y));
+    float angle = i * 2.39996323f;
+    return Vec3f(radius * std::cos(angle), y, radius * std::sin(angle));
+}
+
+float get_overdraw(const uint32_t* indices, int triangle_count, const Vec3f* vertices, int vertex_count, int view_count, int resolution)
+{
+    BoundingVolume bounds = get_bounding_volume(vertices, vertex_count);
+    if (triangle_count == 0 || bounds.sphere_radius <= 0.0f) return 0.0f;
+
+    const float far = std::numeric_limits<float>::infinity();
+    std::vector<float> depths (resolution * resolution);
+    std::vector<Vec3f> projected (vertex_count);
+    long long shaded = 0, covered = 0;
+
+    for (int view = 0; view < view_count; view++)
+    {
+        // Camera looks along forward, x and y span the plane across it
+        Vec3f forward = get_view_direction(view, view_count);
+        Vec3f up = std::fabs(forward.y) < 0.9f ? Vec3f(0.0f, 1.0f, 0.0f) : Vec3f(1.0f, 0.0f, 0.0f);
+        Vec3f x_axis = (up ^ forward).normalized();
+        Vec3f y_axis = forward ^ x_axis;
+
+        float scale = resolution * 0.5f / bounds.sphere_radius;
+        for (int v = 0; v < vertex_count; v++)
+        {
+            Vec3f p = vertices[v] - bounds.sphere_center;
+            projected[v] = Vec3f((p * x_axis) * scale + resolution * 0.5f, (p * y_axis) * scale + resolution * 0.5f, p * forward);
+        }
+        std::fill(depths.begin(), depths.end(), far);
+
+        for (int t = 0; t < triangle_count; t++)
+        {
+            const uint32_t* triangle = indices + t * 3;
+            Vec3f a = projected[triangle[0]], b = projected[triangle[1]], c = projected[triangle[2]];
+
+            // Front faces only, like the renderer draws them
+            Vec3f normal = (vertices[triangle[1]] - vertices[triangle[0]]) ^ (vertices[triangle[2]] - vertices[triangle[0]]);
+            if (normal * forward >= 0.0f) continue;
+
+            float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+            if (area == 0.0f) continue;
+            float inverse_area = 1.0f / area;
+
+            int min_x = std::max(0, (int) std::floor(std::min({ a.x, b.x, c.x })));
+            int max_x = std::min(resolution - 1, (int) std::ceil(std::max({ a.x, b.x, c.x })));
+            int min_y = std::max(0, (int) std::floor(std::min({ a.y, b.y, c.y })));
+            int max_y = std::min(resolution - 1, (int) std::ceil(std::max({ a.y, b.y, c.y })));
+            for (int y = min_y; y <= max_y; y++)
+            {
+                for (int x = min_x; x <= max_x; x++)
+                {
+                    float px = x + 0.5f, py = y + 0.5f;
+                    float w0 = ((c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x)) * inverse_area;
+                    float w1 = ((a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x)) * inverse_area;
+                    float w2 = 1.0f - w0 - w1;
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+                    float depth = w0 * a.z + w1 * b.z + w2 * c.z;
+                    float& stored = depths[x + y * resolution];
+                    if (depth < stored)
+                    {
+                        if (stored == far) covered++;
+                        stored = depth;
+                        shaded++;
+                    }
+                }
+            }
+        }
+    }
+
+    return covered > 0 ? (float) shaded / covered : 0.0f;
+}
@@ -0,0 +1,218 @@
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include "Pack.h"
+
+// Arrays are stored in their in-memory layout
+static_assert(sizeof(Vec3f) == 3 * sizeof(float) && sizeof(Vec2f) == 2 * sizeof(float), "Vec layout");
+
+static uint64_t align_offset(uint64_t offset)
+{
+    return (offset + PACK_ALIGNMENT - 1) & ~(uint64_t) (PACK_ALIGNMENT - 1);
+}
+
+// ROBUSTNESS: every array must lie inside the file, a truncated pack fails to open instead of crashing later
+static bool is_in_file(const Pack* pack, uint64_t offset, uint64_t size)
+{
+    return offset % PACK_ALIGNMENT == 0 && offset <= pack->file.size && size <= pack->file.size - offset;
+}
+
+template<typename T>
+static const T* get_array(const Pack* pack, uint64_t offset, int64_t count, bool& is_valid)
+{
+    if (count < 0 || !is_in_file(pack, offset, count * sizeof(T))) { is_valid = false; return nullptr; }
+    return (const T*) (pack->file.data + offset);
+}
+
+static Mesh* get_mesh_view(const Pack* pack, const PackMesh& entry, bool& is_valid)
+{
+    Mesh* mesh = new Mesh();
+    mesh->vertices       = get_array<Vec3f>   (pack, entry.vertices,    entry.vertex_count,                 is_valid);
+    mesh->uvs            = get_array<Vec2f>   (pack, entry.uvs,         entry.vertex_count,                 is_valid);
+    mesh->normals        = get_array<Vec3f>   (pack, entry.normals,     entry.normal_count,                 is_valid);
+    mesh->indices        = get_array<uint32_t>(pack, entry.indices,     (int64_t) entry.triangle_count * 3, is_valid);
+    mesh->positions_x    = get_array<float>   (pack, entry.positions_x, entry.vertex_count,                 is_valid);
+    mesh->positions_y    = get_array<float>   (pack, entry.positions_y, entry.vertex_count,                 is_valid);
+    mesh->positions_z    = get_array<float>   (pack, entry.positions_z, entry.vertex_count,                 is_valid);
+    mesh->vertex_count   = entry.vertex_count;
+    mesh->normal_count   = entry.normal_count;
+    mesh->triangle_count = entry.triangle_count;
+    mesh->bounds         = entry.bounds;
+    return mesh;
+}
+
+// NOTE: index buffers are trusted, a pack is only ever made by write_pack
+bool open_pack(const char* filename, Pack* pack)
+{
+    if (!map_file(filename, &pack->file))
+    {
+        std::cerr << "Error:: could not open pack file " << filename << '\n';
+        return false;
+    }
+
+    const PackHeader* header = (const PackHeader*) pack->file.data;
+    bool is_valid = pack->file.size >= sizeof(PackHeader) && memcmp(header->magic, PACK_MAGIC, 4) == 0 && header->version == PACK_VERSION;
+
+    const PackMesh* mesh_table = is_valid ? get_array<PackMesh>(pack, header->meshes_offset, header->mesh_count, is_valid) : nullptr;
+    for (int m = 0; is_valid && m < header->mesh_count; m++)
+    {
+        pack->mesh_names.push_back(mesh_table[m].name);
+        pack->meshes.push_back(get_mesh_view(pack, mesh_table[m], is_valid));
+    }
+
+    const PackTexture* texture_table = is_valid ? get_array<PackTexture>(pack, header->textures_offset, header->texture_count, is_valid) : nullptr;
+    for (int t = 0; is_valid && t < header->texture_count; t++)
+    {
+        const PackTexture& entry = texture_table[t];
+        is_valid = entry.width > 0 && entry.height > 0 && entry.level_count > 0 && entry.level_count <= MAX_TEXTURE_LEVELS
+                && (entry.format == TEXTURE_R8 || entry.format == TEXTURE_RGBA8) && (entry.layout == TEXTURE_LINEAR || entry.layout == TEXTURE_TILED);
+
+        Texture* texture = new Texture();
+        texture->level_count = entry.level_count;
+        texture->format = (TextureFormat) entry.format;
+        texture->layout = (TextureLayout) entry.layout;
+        int width = entry.width, height = entry.height;
+        for (int level = 0; is_valid && level < entry.level_count; level++)
+        {
+            TextureLevel& view = texture->levels[level];
+            view.data = get_array<uint8_t>(pack, entry.levels[level], get_level_size(width, height, texture->format, texture->layout), is_valid);
+            view.width = width;
+            view.height = height;
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+
+        pack->texture_names.push_back(entry.name);
+        pack->textures.push_back(texture);
+    }
+
+    if (!is_valid)
+    {
+        std::cerr << "Error:: " << filename << " is not a valid pack file (version " << PACK_VERSION << ")\n";
+        close_pack(pack);
+        return false;
+    }
+    return true;
+}
+
+void close_pack(Pack* pack)
+{
+    for (int m = 0; m < pack->meshes.size(); m++) delete pack->meshes[m];
+    pack->meshes.clear();
+    pack->mesh_names.clear();
+    for (int t = 0; t < pack->textures.size(); t++) delete pack->textures[t];
+    pack->textures.clear();
+    pack->texture_names.clear();
+    unmap_file(&pack->file);
+}
+
+Mesh* find_pack_mesh(Pack* pack, const char* name)
+{
+    for (int m = 0; m < pack->meshes.size(); m++)
+    {
+        if (strncmp(pack->mesh_names[m], name, PACK_NAME_SIZE) == 0) return pack->meshes[m];
+    }
+    return nullptr;
+}
+
+Texture* find_pack_texture(Pack* pack, const char* name)
+{
+    for (int t = 0; t < pack->textures.size(); t++)
+    {
+        if (strncmp(pack->texture_names[t], name, PACK_NAME_SIZE) == 0) return pack->textures[t];
+    }
+    return nullptr;
+}
+
+// Arrays are appended one after another, each padded to PACK_ALIGNMENT
+struct PackFileWriter
+{
+    FILE* file;
+    uint64_t offset;
+    bool is_ok;
+};
+
+static uint64_t write_array(PackFileWriter& writer, const void* data, uint64_t size)
+{
+    static const char padding[PACK_ALIGNMENT] = {};
+    uint64_t start = align_offset(writer.offset);
+    if (start > writer.offset) writer.is_ok = writer.is_ok && fwrite(padding, 1, start - writer.offset, writer.file) == start - writer.offset;
+    if (size > 0)              writer.is_ok = writer.is_ok && fwrite(data, 1, size, writer.file) == size;
+    writer.offset = start + size;
+    return start;
+}
+
+static void copy_name(char* name, const char* source)
+{
+    memset(name, 0, PACK_NAME_SIZE);
+    strncpy(name, source, PACK_NAME_SIZE - 1);
+}
+
+bool write_pack(const char* filename, const PackContents& contents)
+{
+    PackFileWriter writer { fopen(filename, "wb"), 0, true };
+    if (!writer.file)
+    {
+        std::cerr << "Error:: could not create pack file " << filename << '\n';
+        return false;
+    }
+
+    // Tables are written once the array offsets are known, header and tables go first so reserve their space
+    PackHeader header = {};
+    memcpy(header.magic, PACK_MAGIC, 4);
+    header.version = PACK_VERSION;
+    header.mesh_count = contents.meshes.size();
+    header.texture_count = contents.textures.size();
+    header.meshes_offset = align_offset(sizeof(PackHeader));
+    header.textures_offset = align_offset(header.meshes_offset + header.mesh_count * sizeof(PackMesh));
+    std::vector<PackMesh> mesh_table (header.mesh_count);
+    std::vector<PackTexture> texture_table (header.texture_count);
+
+    std::vector<char> zeros (align_offset(header.textures_offset + header.texture_count * sizeof(PackTexture)), 0);
+    write_array(writer, zeros.data(), zeros.size());
+
+    for (int m = 0; m < contents.meshes.size(); m++)
+    {
+        const Mesh* mesh = contents.meshes[m];
+        PackMesh& entry = mesh_table[m];
+        copy_name(entry.name, contents.mesh_names[m]);
+        entry.bounds         = mesh->bounds;
+        entry.vertex_count   = mesh->vertex_count;
+        entry.normal_count   = mesh->normal_count;
+        entry.triangle_count = mesh->triangle_count;
+        entry.vertices     = write_array(writer, mesh->vertices,    mesh->vertex_count * sizeof(Vec3f));
+        entry.uvs          = write_array(writer, mesh->uvs,         mesh->vertex_count * sizeof(Vec2f));
+        entry.normals      = write_array(writer, mesh->normals,     mesh->normal_count * sizeof(Vec3f));
+        entry.indices      = write_array(writer, mesh->indices,     (uint64_t) mesh->triangle_count * 3 * sizeof(uint32_t));
+        entry.positions_x  = write_array(writer, mesh->positions_x, mesh->vertex_count * sizeof(float));
+        entry.positions_y  = write_array(writer, mesh->positions_y, mesh->vertex_count * sizeof(float));
+        entry.positions_z  = write_array(writer, mesh->positions_z, mesh->vertex_count * sizeof(float));
+    }
+
+    for (int t = 0; t < contents.textures.size(); t++)
+    {
+        const Texture* texture = contents.textures[t];
+        PackTexture& entry = texture_table[t];
+        copy_name(entry.name, contents.texture_names[t]);
+        entry.width  = texture->levels[0].width;
+        entry.height = texture->levels[0].height;
+        entry.format = texture->format;
+        entry.layout = texture->layout;
+        entry.level_count = texture->level_count;
+        for (int level = 0; level < entry.level_count; level++)
+        {
+            const TextureLevel& texels = texture->levels[level];
+            entry.levels[level] = write_array(writer, texels.data, get_level_size(texels.width, texels.height, texture->format, texture->layout));
+        }
+    }
+
+    writer.is_ok = writer.is_ok && fseek(writer.file, 0, SEEK_SET) == 0;
+    writer.offset = 0;
+    write_array(writer, &header, sizeof(PackHeader));
+    write_array(writer, mesh_table.data(), mesh_table.size() * sizeof(PackMesh));
+    write_array(writer, texture_table.data(), texture_table.size() * sizeof(PackTexture));
+
+    writer.is_ok = fclose(writer.file) == 0 && writer.is_ok;
+    if (!writer.is_ok) std::cerr << "Error:: could not write pack file " << filename << '\n';
+    return writer.is_ok;
+}
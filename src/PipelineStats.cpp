@@ -0,0 +1,96 @@
+#include <cstring>
+#include <iostream>
+#include "PipelineStats.h"
+
+struct StatsField
+{
+    const char* name;
+    uint64_t PipelineStats::* counter;
+};
+
+// Column order of both formats
+static const StatsField STATS_FIELDS[] =
+{
+    { "objects_submitted",     &PipelineStats::objects_submitted },
+    { "objects_culled",        &PipelineStats::objects_culled },
+    { "faces_submitted",       &PipelineStats::faces_submitted },
+    { "faces_backface_culled", &PipelineStats::faces_backface_culled },
+    { "faces_rejected",        &PipelineStats::faces_rejected },
+    { "polygons_clipped",      &PipelineStats::polygons_clipped },
+    { "polygons_binned",       &PipelineStats::polygons_binned },
+    { "triangles_binned",      &PipelineStats::triangles_binned },
+    { "bin_entries",           &PipelineStats::bin_entries },
+    { "triangles_rasterized",  &PipelineStats::triangles_rasterized },
+    { "fragments_generated",   &PipelineStats::fragments_generated },
+    { "depth_passes",          &PipelineStats::depth_passes },
+    { "depth_fails",           &PipelineStats::depth_fails },
+    { "pixels_covered",        &PipelineStats::pixels_covered },
+    { "pixel_count",           &PipelineStats::pixel_count },
+};
+const int STATS_FIELD_COUNT = sizeof(STATS_FIELDS) / sizeof(STATS_FIELDS[0]);
+
+void add_pipeline_stats(const PipelineStats& stats, PipelineStats& total)
+{
+    for (int i = 0; i < STATS_FIELD_COUNT; i++) total.*STATS_FIELDS[i].counter += stats.*STATS_FIELDS[i].counter;
+}
+
+float get_frame_overdraw(const PipelineStats& stats)
+{
+    return stats.pixels_covered ? (float) stats.depth_passes / stats.pixels_covered : 0.0f;
+}
+
+float get_frame_depth_complexity(const PipelineStats& stats)
+{
+    return stats.pixels_covered ? (float) stats.fragments_generated / stats.pixels_covered : 0.0f;
+}
+
+bool open_stats_writer(const char* path, StatsWriter* writer)
+{
+    const char* extension = strrchr(path, '.');
+    writer->is_json = extension && !strcmp(extension, ".json");
+    writer->frame_count = 0;
+    writer->file = fopen(path, "w");
+    if (!writer->file)
+    {
+        std::cerr << "Error:: could not open " << path << '\n';
+        return false;
+    }
+
+    if (writer->is_json)
+    {
+        fprintf(writer->file, "[");
+        return true;
+    }
+
+    fprintf(writer->file, "frame");
+    for (int i = 0; i < STATS_FIELD_COUNT; i++) fprintf(writer->file, ",%s", STATS_FIELDS[i].name);
+    fprintf(writer->file, ",overdraw,depth_complexity\n");
+    return true;
+}
+
+void write_stats_frame(const PipelineStats& stats, StatsWriter* writer)
+{
+    if (!writer->file) return;
+
+    if (writer->is_json)
+    {
+        fprintf(writer->file, "%s\n{\"frame\":%d", writer->frame_count ? "," : "", writer->frame_count);
+        for (int i = 0; i < STATS_FIELD_COUNT; i++) fprintf(writer->file, ",\"%s\":%llu", STATS_FIELDS[i].name, (unsigned long long) (stats.*STATS_FIELDS[i].counter));
+        fprintf(writer->file, ",\"overdraw\":%.4f,\"depth_complexity\":%.4f}", get_frame_overdraw(stats), get_frame_depth_complexity(stats));
+    }
+    else
+    {
+        fprintf(writer->file, "%d", writer->frame_count);
+        for (int i = 0; i < STATS_FIELD_COUNT; i++) fprintf(writer->file, ",%llu", (unsigned long long) (stats.*STATS_FIELDS[i].counter));
+        fprintf(writer->file, ",%.4f,%.4f\n", get_frame_overdraw(stats), get_frame_depth_complexity(stats));
+    }
+    writer->frame_count++;
+}
+
+void close_stats_writer(StatsWriter* writer)
+{
+    if (!writer->file) return;
+    if (writer->is_json) fprintf(writer->file, "\n]\n");
+    fclose(writer->file);
+    writer->file = nullptr;
+}
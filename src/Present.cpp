@@ -0,0 +1,117 @@
+#include <cmath>
+#include <cstring>
+#include "Present.h"
+#include "Profiler.h"
+#include "Simd.h"
+#include "Util.h"
+#include "WorkerPool.h"
+
+const int SRGB_LUT_SIZE = 4096; // linear steps, fine enough that every 8-bit sRGB value near black is reachable
+const int PRESENT_ROWS_PER_TASK = 16;
+
+struct SrgbLut
+{
+    uint8_t values[SRGB_LUT_SIZE];
+};
+
+static SrgbLut build_srgb_lut()
+{
+    SrgbLut lut;
+    for (int i = 0; i < SRGB_LUT_SIZE; i++)
+    {
+        float linear = (float) i / (SRGB_LUT_SIZE - 1);
+        float encoded = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+        lut.values[i] = encoded * 255.0f + 0.5f;
+    }
+    return lut;
+}
+
+// Built once, on first use
+static const SrgbLut& get_srgb_lut()
+{
+    static const SrgbLut lut = build_srgb_lut();
+    return lut;
+}
+
+// Pixel's channels in byte order as 0 to 255 (truncated the same way buffer_to_tga_image does), alpha opaque
+template <PixelOrder ORDER>
+static inline Float4 get_byte_lanes(Float4 rgb)
+{
+    rgb = min_float4(max_float4(rgb, float4(0.0f)), float4(1.0f));
+    if (ORDER == PIXEL_BGRA) rgb = shuffle<2, 1, 0, 3>(rgb);
+    return rgb * float4(255.9999f, 255.9999f, 255.9999f, 0.0f) + float4(0.0f, 0.0f, 0.0f, 255.0f);
+}
+
+// ASSUMPTION: little endian, the lowest byte of the word is the first in memory
+template <PixelOrder ORDER>
+static inline uint32_t get_srgb_pixel(Float4 rgb, const SrgbLut& lut)
+{
+    int32_t index[4];
+    store_int4(index, min_float4(max_float4(rgb, float4(0.0f)), float4(1.0f)) * float4(SRGB_LUT_SIZE - 1) + float4(0.5f));
+
+    uint32_t r = lut.values[index[0]], g = lut.values[index[1]], b = lut.values[index[2]];
+    if (ORDER == PIXEL_RGBA) return r | (g << 8) | (b << 16) | (0xFFu << 24);
+    return b | (g << 8) | (r << 16) | (0xFFu << 24);
+}
+
+// NOTE: a pixel load takes 4 floats, the 4th being the next pixel's red, so the last pixel of a row always goes through the tail
+template <PixelOrder ORDER>
+static void convert_row(const float* rgb, int width, bool is_srgb, uint8_t* out)
+{
+    const SrgbLut& lut = get_srgb_lut();
+
+    int x = 0;
+    if (is_srgb)
+    {
+        for (; x + 1 < width; x++)
+        {
+            uint32_t pixel = get_srgb_pixel<ORDER>(load_float4(rgb + x * 3), lut);
+            memcpy(out + x * 4, &pixel, 4);
+        }
+    }
+    else
+    {
+        for (; x + 4 < width; x += 4)
+        {
+            const float* p = rgb + x * 3;
+            store_bytes16(out + x * 4, get_byte_lanes<ORDER>(load_float4(p)), get_byte_lanes<ORDER>(load_float4(p + 3)),
+                                       get_byte_lanes<ORDER>(load_float4(p + 6)), get_byte_lanes<ORDER>(load_float4(p + 9)));
+        }
+    }
+
+    for (; x < width; x++)
+    {
+        const float* p = rgb + x * 3;
+        Float4 rgb_lanes = float4(p[0], p[1], p[2], 0.0f);
+        if (is_srgb)
+        {
+            uint32_t pixel = get_srgb_pixel<ORDER>(rgb_lanes, lut);
+            memcpy(out + x * 4, &pixel, 4);
+        }
+        else
+        {
+            uint8_t bytes[16];
+            Float4 lanes = get_byte_lanes<ORDER>(rgb_lanes);
+            store_bytes16(bytes, lanes, lanes, lanes, lanes);
+            memcpy(out + x * 4, bytes, 4);
+        }
+    }
+}
+
+void present_pixels(const float* rgb, bool is_srgb, const PresentTarget& target)
+{
+    int task_count = (target.height + PRESENT_ROWS_PER_TASK - 1) / PRESENT_ROWS_PER_TASK;
+    parallel_for(task_count, [&](int task, int worker)
+    {
+        ProfileScope scope (STAGE_PRESENT, worker);
+        int first_row = task * PRESENT_ROWS_PER_TASK;
+        int last_row = min_i(first_row + PRESENT_ROWS_PER_TASK, target.height);
+        for (int y = first_row; y < last_row; y++)
+        {
+            const float* src = rgb + (size_t) y * target.width * 3;
+            uint8_t* dst = target.pixels + (size_t) (target.height - 1 - y) * target.pitch;
+            if (target.order == PIXEL_RGBA) convert_row<PIXEL_RGBA>(src, target.width, is_srgb, dst);
+            else                            convert_row<PIXEL_BGRA>(src, target.width, is_srgb, dst);
+        }
+    });
+}
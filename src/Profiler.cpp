@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include "Profiler.h"
+
+const int RING_SIZE = 1 << 15; // events per worker, a power of 2
+const int FRAME_HISTORY = 128;
+
+struct ProfileEvent
+{
+    uint64_t start_ns, end_ns;
+    ProfileStage stage;
+};
+
+struct ProfileRing
+{
+    ProfileEvent events[RING_SIZE];
+    std::atomic<uint64_t> head { 0 }; // events ever written, only its worker writes it
+    uint64_t frame_start = 0;         // head at the last end_profiler_frame
+};
+
+bool is_profiling = false;
+
+static std::vector<ProfileRing*> rings;
+static std::chrono::steady_clock::time_point start_time;
+static float history[STAGE_COUNT][FRAME_HISTORY]; // ms per frame, negative when the stage did not run
+static int history_count = 0, history_next = 0;
+
+static const char* STAGE_NAMES[STAGE_COUNT] = { "frame", "cull", "vertex", "clip", "raster", "clear", "resolve", "blit", "present" };
+
+void init_profiler(int worker_count)
+{
+    for (ProfileRing* ring : rings) delete ring;
+    rings.clear();
+    for (int w = 0; w < worker_count; w++) rings.push_back(new ProfileRing());
+
+    start_time = std::chrono::steady_clock::now();
+    history_count = 0;
+    history_next = 0;
+}
+
+void set_profiling(bool is_enabled)
+{
+    is_profiling = is_enabled && !rings.empty();
+}
+
+uint64_t get_profile_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void record_profile_event(ProfileStage stage, int worker, uint64_t start_ns, uint64_t end_ns)
+{
+    if (worker < 0 || worker >= rings.size()) return; // ROBUSTNESS
+
+    ProfileRing& ring = *rings[worker];
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head & (RING_SIZE - 1)] = ProfileEvent { start_ns, end_ns, stage };
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+// NOTE: call between frames, events recorded while it runs may be counted in the next frame
+void end_profiler_frame()
+{
+    uint64_t total_ns[STAGE_COUNT] = {};
+    bool did_run[STAGE_COUNT] = {};
+
+    for (ProfileRing* ring : rings)
+    {
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = std::max(ring->frame_start, head > RING_SIZE ? head - RING_SIZE : 0); // older ones were overwritten
+        for (uint64_t e = first; e < head; e++)
+        {
+            const ProfileEvent& event = ring->events[e & (RING_SIZE - 1)];
+            total_ns[event.stage] += event.end_ns - event.start_ns;
+            did_run[event.stage] = true;
+        }
+        ring->frame_start = head;
+    }
+
+    for (int s = 0; s < STAGE_COUNT; s++) history[s][history_next] = did_run[s] ? total_ns[s] / 1e6f : -1.0f;
+    history_next = (history_next + 1) % FRAME_HISTORY;
+    history_count = std::min(history_count + 1, FRAME_HISTORY);
+}
+
+ProfileStats get_stage_stats(ProfileStage stage)
+{
+    std::vector<float> times;
+    for (int f = 0; f < history_count; f++)
+    {
+        if (history[stage][f] >= 0.0f) times.push_back(history[stage][f]);
+    }
+
+    ProfileStats stats = { 0.0f, 0.0f, 0.0f, (int) times.size() };
+    if (times.empty()) return stats;
+
+    std::sort(times.begin(), times.end());
+    float sum = 0.0f;
+    for (float t : times) sum += t;
+    stats.min_ms = times.front();
+    stats.avg_ms = sum / times.size();
+    stats.p99_ms = times[(int) std::ceil(0.99f * times.size()) - 1];
+    return stats;
+}
+
+const char* get_stage_name(ProfileStage stage)
+{
+    return STAGE_NAMES[stage];
+}
+
+void print_profile()
+{
+    std::cout << "stage, frames, min ms, avg ms, p99 ms\n";
+    for (int s = 0; s < STAGE_COUNT; s++)
+    {
+        ProfileStats stats = get_stage_stats((ProfileStage) s);
+        if (stats.frame_count == 0) continue;
+        std::cout << STAGE_NAMES[s] << ", " << stats.frame_count << ", " << stats.min_ms << ", " << stats.avg_ms << ", " << stats.p99_ms << '\n';
+    }
+}
+
+// Trace event format, complete ("X") events with microsecond times, one thread per worker
+bool write_chrome_trace(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        std::cerr << "Error:: could not open " << path << '\n';
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool is_first = true;
+    for (int w = 0; w < rings.size(); w++)
+    {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}", is_first ? "" : ",\n", w, w);
+        is_first = false;
+
+        const ProfileRing& ring = *rings[w];
+        uint64_t head = ring.head.load(std::memory_order_acquire);
+        for (uint64_t e = head > RING_SIZE ? head - RING_SIZE : 0; e < head; e++)
+        {
+            const ProfileEvent& event = ring.events[e & (RING_SIZE - 1)];
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"render\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    STAGE_NAMES[event.stage], w, event.start_ns / 1e3, (event.end_ns - event.start_ns) / 1e3);
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    bool is_written = !ferror(file);
+    fclose(file);
+    if (!is_written) std::cerr << "Error:: could not write " << path << '\n';
+    return is_written;
+}
@@ -147,7 +147,7 @@ void rasterize_line(const Vertex& v0, const Vertex& v1, int width, std::vector<F
     }
 }
 
-void rasterize_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, int height, int width, std::vector<Fragment>& fragments)
+bool set_up_scanline_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Rect& bounds, ScanlineTriangle& tri)
 {
     /**
      * PROCESS:
@@ -157,28 +157,22 @@ void rasterize_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, in
      * 
      * set up left edge tracker
      * set up right edge tracker
+     * set up scanline edge tracker (left to right)
      * 
-     * for each scanline triangle spans
-     *      set up current scanline
-     *      rasterize scanline from left to right
-     * 
-     *      take step forward on left edge tracker
-     *      take step forward on right edge tracker
+     * keep only what the scanline loop needs (see rasterize_triangle in header)
      */
 
-    const float FUDGE = 1.0f;
-    assert((v0.device.x >= 0.0f && v0.device.x <= width)  || (v0.device.x > width  && (v0.device.x - width) < FUDGE)  || (v0.device.x < 0.0f && std::abs(v0.device.x) < FUDGE)); 
-    assert((v0.device.y >= 0.0f && v0.device.y <= height) || (v0.device.y > height && (v0.device.y - height) < FUDGE) || (v0.device.y < 0.0f && std::abs(v0.device.y) < FUDGE)); 
-    assert((v1.device.x >= 0.0f && v1.device.x <= width)  || (v1.device.x > width  && (v1.device.x - width) < FUDGE)  || (v1.device.x < 0.0f && std::abs(v1.device.x) < FUDGE)); 
-    assert((v1.device.y >= 0.0f && v1.device.y <= height) || (v1.device.y > height && (v1.device.y - height) < FUDGE) || (v1.device.y < 0.0f && std::abs(v1.device.y) < FUDGE)); 
-    assert((v2.device.x >= 0.0f && v2.device.x <= width)  || (v2.device.x > width  && (v2.device.x - width) < FUDGE)  || (v2.device.x < 0.0f && std::abs(v2.device.x) < FUDGE)); 
-    assert((v2.device.y >= 0.0f && v2.device.y <= height) || (v2.device.y > height && (v2.device.y - height) < FUDGE) || (v2.device.y < 0.0f && std::abs(v2.device.y) < FUDGE)); 
-
     // NOTE: triangle rasterization process can sample points outside of the triangle
     //       this can lead to unexpected values for the interpolated vertex
     //       like out-of-bounds uvs, thus this must be dealt
     
-    if (std::abs((v1.device - v0.device) ^ (v2.device - v0.device))/2.0f < 1.0f) return;
+    if (std::abs((v1.device - v0.device) ^ (v2.device - v0.device))/2.0f < 1.0f) return false;
+
+    float min_y = std::min(v0.device.y, std::min(v1.device.y, v2.device.y));
+    float max_y = std::max(v0.device.y, std::max(v1.device.y, v2.device.y));
+    float min_x = std::min(v0.device.x, std::min(v1.device.x, v2.device.x));
+    float max_x = std::max(v0.device.x, std::max(v1.device.x, v2.device.x));
+    if (max_y < bounds.y0 || min_y > bounds.y1 || max_x < bounds.x0 || min_x > bounds.x1) return false;
 
     struct TriangleVertexLabels { const Vertex *apex, *left, *right; } labels;
     // Set the apex
@@ -194,83 +188,89 @@ void rasterize_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, in
     EdgeTracker left;
     EdgeTracker right;
 
-    int start_scanline;
     bool is_apex_above_other_vertices = labels.apex->device.y > labels.left->device.y;
-    float delta_y;
     if (is_apex_above_other_vertices)
     {
-        delta_y  = (ceil(labels.left->device.y) - labels.left->device.y); // same for both edges
+        tri.delta_y = (ceil(labels.left->device.y) - labels.left->device.y); // same for both edges
         left = set_up_edge_tracker(*labels.left, *labels.apex, true);
         right = set_up_edge_tracker(*labels.right, *labels.apex, true);
-        start_scanline = ceil(labels.left->device.y);
+        tri.start_scanline = ceil(labels.left->device.y);
     }
     else
     {
-        delta_y  = (ceil(labels.apex->device.y) - labels.apex->device.y);
+        tri.delta_y = (ceil(labels.apex->device.y) - labels.apex->device.y);
         left = set_up_edge_tracker(*labels.apex, *labels.left, true);
         right = set_up_edge_tracker(*labels.apex, *labels.right, true);        
-        start_scanline = ceil(labels.apex->device.y);
+        tri.start_scanline = ceil(labels.apex->device.y);
     }
 
-    // Initial step to get on scanline
-    take_step(left, delta_y);
-    take_step(right, delta_y);
-    int cur_scanline = start_scanline;
-    cur_scanline = max_i(0, cur_scanline); // ROBUSTNESS
+    tri.first_scanline = max_i(bounds.y0, tri.start_scanline); // ROBUSTNESS
+    tri.stop_scanline = is_apex_above_other_vertices ? ceil(labels.apex->device.y) : ceil(labels.left->device.y);
+    tri.stop_scanline = min_i(bounds.y1, tri.stop_scanline); // ROBUSTNESS
 
     EdgeTracker scanline_edge = set_up_edge_tracker(*labels.left, *labels.right, false);
-    int stop_scanline = is_apex_above_other_vertices ? ceil(labels.apex->device.y) : ceil(labels.left->device.y);
-    stop_scanline = min_i(height, stop_scanline); // ROBUSTNESS
 
-    while (cur_scanline < stop_scanline)
-    {
-        float delta_x = (floor(left.v.device.x) - left.v.device.x);
-        scanline_edge.v = left.v;
-        take_step(scanline_edge, delta_x);
+    tri.left_x         = left.v.device.x;
+    tri.left_x_inc     = left.v_inc.device.x;
+    tri.right_x        = right.v.device.x;
+    tri.right_x_inc    = right.v_inc.device.x;
+    tri.left_depth     = left.v.depth;
+    tri.left_depth_inc = left.v_inc.depth;
+    tri.left_uv        = left.v.uv;
+    tri.left_uv_inc    = left.v_inc.uv;
+    tri.span_depth_inc = scanline_edge.v_inc.depth;
+    tri.span_uv_inc    = scanline_edge.v_inc.uv;
+
+    return tri.first_scanline < tri.stop_scanline;
+}
 
-        Vec2i cur_pixel (floor(left.v.device.x), cur_scanline);
-        cur_pixel.x = max_i(0, cur_pixel.x); // ROBUSTNESS
+void get_uv_gradients(const Vertex* vertices, int vertex_count, Vec2f& duv_dx, Vec2f& duv_dy)
+{
+    duv_dx = duv_dy = Vec2f(0.0f, 0.0f);
 
-        int right_stop = floor(right.v.device.x);
-        right_stop = min_i(width, right_stop); // ROBUSTNESS
-        while (cur_pixel.x < right_stop)
+    int largest = 0;
+    float largest_area = 0.0f;
+    for (int i = 1; i + 1 < vertex_count; i++)
+    {
+        float area = (vertices[i].device - vertices[0].device) ^ (vertices[i + 1].device - vertices[0].device);
+        if (std::abs(area) > std::abs(largest_area))
         {
-            Fragment frag;
-            frag.pixel = Vec2i(cur_pixel.x, cur_pixel.y);
-            frag.depth = scanline_edge.v.depth;
-            frag.uv = scanline_edge.v.uv;
-            fragments.push_back(frag);
-
-            cur_pixel.x++;
-            take_step(scanline_edge);
+            largest_area = area;
+            largest = i;
         }
-
-        take_step(left);
-        right.v.device.x += right.v_inc.device.x; // only need to calculate x value
-        cur_scanline++;
     }
+    if (largest_area == 0.0f) return;
+
+    // Solves the gradient from the two edges leaving vertex 0 (Cramer's rule)
+    const Vertex& a = vertices[0];
+    Vec2f e1 = vertices[largest].device - a.device, e2 = vertices[largest + 1].device - a.device;
+    Vec2f duv1 = vertices[largest].uv - a.uv, duv2 = vertices[largest + 1].uv - a.uv;
+    float one_over_area = 1.0f / largest_area;
+    duv_dx = Vec2f(duv1.x * e2.y - duv2.x * e1.y, duv1.y * e2.y - duv2.y * e1.y) * one_over_area;
+    duv_dy = Vec2f(duv2.x * e1.x - duv1.x * e2.x, duv2.y * e1.x - duv1.y * e2.x) * one_over_area;
 }
 
 // Polygon is assumed 'flat' (in all dimension)
 // Polygon must have some winding
-void rasterize_polygon(const std::vector<Vertex>& vertices, int height, int width, std::vector<Fragment>& fragments)
+void split_polygon(const Vertex* vertices, int vertex_count, std::vector<Vertex>& triangles)
 {
     // ROBUSTNESS: degenerate polygon check?
 
-    // Allocate vectors once
-    static std::vector<Vertex> cur_polygon (15);
-    static std::vector<Vertex> top (15);
-    static std::vector<Vertex> bottom (15);
+    // Allocate vectors once (per thread, tiles are rasterized in parallel)
+    thread_local std::vector<Vertex> cur_polygon (15);
+    thread_local std::vector<Vertex> top (15);
+    thread_local std::vector<Vertex> bottom (15);
+    thread_local std::vector<float> sorted_heights (15);
     cur_polygon.clear();
     top.clear();
     bottom.clear();
 
     // TODO: switch to insertion sort (apparently its faster on smaller lists)
-    std::vector<float> sorted_heights (vertices.size());
-    for (int i = 0; i < sorted_heights.size(); i++) sorted_heights[i] = vertices[i].device.y;
+    sorted_heights.resize(vertex_count);
+    for (int i = 0; i < vertex_count; i++) sorted_heights[i] = vertices[i].device.y;
     std::sort(sorted_heights.begin(), sorted_heights.end());
 
-    for (int i = 0; i < vertices.size(); i++) cur_polygon.push_back(vertices[i]);
+    for (int i = 0; i < vertex_count; i++) cur_polygon.push_back(vertices[i]);
 
     for (int i = 0; i < sorted_heights.size(); i++)
     {
@@ -279,16 +279,103 @@ void rasterize_polygon(const std::vector<Vertex>& vertices, int height, int widt
 
         if (bottom.size() == 4)
         {
-            rasterize_triangle(bottom[0], bottom[1], bottom[2], height, width, fragments);
-            rasterize_triangle(bottom[2], bottom[3], bottom[0], height, width, fragments);
+            triangles.push_back(bottom[0]); triangles.push_back(bottom[1]); triangles.push_back(bottom[2]);
+            triangles.push_back(bottom[2]); triangles.push_back(bottom[3]); triangles.push_back(bottom[0]);
         }
         else if (bottom.size() == 3)
         {
-            rasterize_triangle(bottom[0], bottom[1], bottom[2], height, width, fragments);
+            triangles.push_back(bottom[0]); triangles.push_back(bottom[1]); triangles.push_back(bottom[2]);
         }
 
         std::swap(cur_polygon, top);
         top.clear();
         bottom.clear();
     }
-}
\ No newline at end of file
+}
+
+static EdgeFunction set_up_edge_function(const Vec2f& p, const Vec2f& q)
+{
+    EdgeFunction edge;
+    edge.a = p.y - q.y;
+    edge.b = q.x - p.x;
+    edge.origin = p;
+    edge.is_top_left = (edge.a > 0.0f) || (edge.a == 0.0f && edge.b < 0.0f); // left edges go down, top edges go left
+    return edge;
+}
+
+static AttributePlane set_up_attribute_plane(float f0, float f1, float f2, const EdgeFunction& e1, const EdgeFunction& e2, float one_over_area)
+{
+    // Barycentric weights of v1 and v2 are e1/area and e2/area
+    AttributePlane plane;
+    plane.f  = f0;
+    plane.dx = ((f1 - f0) * e1.a + (f2 - f0) * e2.a) * one_over_area;
+    plane.dy = ((f1 - f0) * e1.b + (f2 - f0) * e2.b) * one_over_area;
+    return plane;
+}
+
+bool set_up_half_space_triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, const Rect& bounds, HalfSpaceTriangle& tri)
+{
+    /**
+     * PROCESS:
+     * 
+     * make triangle counter-clockwise
+     * set up the three edge functions and the depth/uv attribute planes
+     * find the pixel blocks covering the triangle's bounding box (inside bounds)
+     */
+
+    const Vertex* a = &v0;
+    const Vertex* b = &v1;
+    const Vertex* c = &v2;
+
+    float area = (b->device - a->device) ^ (c->device - a->device);
+    if (area == 0.0f) return false;
+    if (area < 0.0f)
+    {
+        std::swap(b, c);
+        area = -area;
+    }
+    float one_over_area = 1.0f / area;
+
+    tri.edges[0] = set_up_edge_function(b->device, c->device);
+    tri.edges[1] = set_up_edge_function(c->device, a->device); // weight of b
+    tri.edges[2] = set_up_edge_function(a->device, b->device); // weight of c
+
+    tri.origin = a->device;
+    tri.depth  = set_up_attribute_plane(a->depth, b->depth, c->depth, tri.edges[1], tri.edges[2], one_over_area);
+    tri.u      = set_up_attribute_plane(a->uv.x,  b->uv.x,  c->uv.x,  tri.edges[1], tri.edges[2], one_over_area);
+    tri.v      = set_up_attribute_plane(a->uv.y,  b->uv.y,  c->uv.y,  tri.edges[1], tri.edges[2], one_over_area);
+
+    // Bounding box of the pixels whose centers could be covered
+    float min_x = std::min(a->device.x, std::min(b->device.x, c->device.x));
+    float max_x = std::max(a->device.x, std::max(b->device.x, c->device.x));
+    float min_y = std::min(a->device.y, std::min(b->device.y, c->device.y));
+    float max_y = std::max(a->device.y, std::max(b->device.y, c->device.y));
+    tri.x0 = max_i(bounds.x0, floor(min_x));
+    tri.x1 = min_i(bounds.x1, ceil(max_x));
+    tri.y0 = max_i(bounds.y0, floor(min_y));
+    tri.y1 = min_i(bounds.y1, ceil(max_y));
+    if (tri.x0 >= tri.x1 || tri.y0 >= tri.y1) return false;
+
+    // Blocks stay aligned to the bounds, so tiles split the same way no matter the triangle
+    tri.x0 = bounds.x0 + ((tri.x0 - bounds.x0) / RASTER_BLOCK_SIZE) * RASTER_BLOCK_SIZE;
+    tri.y0 = bounds.y0 + ((tri.y0 - bounds.y0) / RASTER_BLOCK_SIZE) * RASTER_BLOCK_SIZE;
+
+    return true;
+}
+
+void rasterize_polygon(const std::vector<Vertex>& vertices, int height, int width, std::vector<Fragment>& fragments)
+{
+    rasterize_polygon(vertices, Rect { 0, 0, width, height }, fragments);
+}
+
+void rasterize_polygon(const std::vector<Vertex>& vertices, const Rect& bounds, std::vector<Fragment>& fragments)
+{
+    FragmentCollector collector { fragments };
+    rasterize_polygon(vertices.data(), vertices.size(), bounds, collector);
+}
+
+void rasterize_polygon_half_space(const std::vector<Vertex>& vertices, const Rect& bounds, std::vector<Fragment>& fragments)
+{
+    FragmentCollector collector { fragments };
+    rasterize_polygon_half_space(vertices.data(), vertices.size(), bounds, collector);
+}
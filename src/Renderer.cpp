@@ -0,0 +1,531 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "Renderer.h"
+#include "Geometry.h"
+#include "WorkerPool.h"
+#include "VertexStage.h"
+#include "Cull.h"
+#include "Util.h"
+#include "Simd.h"
+#include "Profiler.h"
+
+void init_frame_buffer(int width, int height, ColorFormat color_format, DepthFormat depth_format, FrameBuffer* frame_buffer)
+{
+    frame_buffer->color_format = color_format;
+    frame_buffer->depth_format = depth_format;
+    frame_buffer->epoch = 1;
+    frame_buffer->clear_color = Vec3f(0.0f);
+    frame_buffer->depth_scale = 1.0f;
+    frame_buffer->depth_offset = 0.0f;
+    resize_frame_buffer(width, height, frame_buffer);
+}
+
+// Contents are lost, every tile reads as cleared until it is drawn into again
+// NOTE: storage only ever grows, so shrinking (or growing back within a reservation) does not allocate
+void resize_frame_buffer(int width, int height, FrameBuffer* frame_buffer)
+{
+    frame_buffer->width = width;
+    frame_buffer->height = height;
+    frame_buffer->tiles_x = (width  + TILE_SIZE - 1) / TILE_SIZE;
+    frame_buffer->tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    frame_buffer->color.resize((size_t) width * height);
+    frame_buffer->depth.resize((size_t) width * height * get_depth_size(frame_buffer->depth_format));
+    frame_buffer->tile_epochs.assign(frame_buffer->tiles_x * frame_buffer->tiles_y, 0);
+}
+
+void reserve_frame_buffer(int width, int height, FrameBuffer* frame_buffer)
+{
+    int tiles_x = (width  + TILE_SIZE - 1) / TILE_SIZE;
+    int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    frame_buffer->color.reserve((size_t) width * height);
+    frame_buffer->depth.reserve((size_t) width * height * get_depth_size(frame_buffer->depth_format));
+    frame_buffer->tile_epochs.reserve(tiles_x * tiles_y);
+}
+
+// NOTE: touches no pixels, tiles are cleared lazily by the raster stage
+void clear_frame_buffer(const Vec3f& clear_color, FrameBuffer* frame_buffer)
+{
+    frame_buffer->clear_color = clear_color;
+    frame_buffer->epoch++;
+}
+
+static Vec3f unpack_color(uint32_t packed, ColorFormat format)
+{
+    if (format == COLOR_RGBA8) return Vec3f(packed & 0xFF, (packed >> 8) & 0xFF, (packed >> 16) & 0xFF) * (1.0f / 255.0f);
+    return Vec3f(packed & 0x3FF, (packed >> 10) & 0x3FF, (packed >> 20) & 0x3FF) * (1.0f / 1023.0f);
+}
+
+static Rect get_tile_rect(int t, const FrameBuffer* frame_buffer)
+{
+    int tx = t % frame_buffer->tiles_x, ty = t / frame_buffer->tiles_x;
+    return Rect { tx * TILE_SIZE, ty * TILE_SIZE, min_i((tx + 1) * TILE_SIZE, frame_buffer->width), min_i((ty + 1) * TILE_SIZE, frame_buffer->height) };
+}
+
+// Brings a stale tile up to the current epoch, filling it with the clear values
+static void prepare_tile(int t, int worker, FrameBuffer* frame_buffer)
+{
+    if (frame_buffer->tile_epochs[t] == frame_buffer->epoch) return;
+    frame_buffer->tile_epochs[t] = frame_buffer->epoch;
+
+    ProfileScope scope (STAGE_CLEAR, worker);
+
+    Rect tile = get_tile_rect(t, frame_buffer);
+    uint32_t clear_color = pack_color(frame_buffer->clear_color.raw, frame_buffer->color_format);
+    int depth_size = get_depth_size(frame_buffer->depth_format);
+    for (int y = tile.y0; y < tile.y1; y++)
+    {
+        size_t row = (size_t) y * frame_buffer->width;
+        std::fill(&frame_buffer->color[row + tile.x0], &frame_buffer->color[row + tile.x1], clear_color);
+
+        // Integer depths clear to 0, the far plane
+        uint8_t* depth_row = &frame_buffer->depth[(row + tile.x0) * depth_size];
+        if (frame_buffer->depth_format == DEPTH_32F) std::fill((float*) depth_row, (float*) depth_row + (tile.x1 - tile.x0), MAX_DEPTH);
+        else                                         memset(depth_row, 0, (tile.x1 - tile.x0) * depth_size);
+    }
+}
+
+void resolve_frame_buffer(const FrameBuffer* frame_buffer, Buffer* color)
+{
+    ProfileScope scope (STAGE_RESOLVE, 0);
+    for (int t = 0; t < frame_buffer->tiles_x * frame_buffer->tiles_y; t++)
+    {
+        Rect tile = get_tile_rect(t, frame_buffer);
+        bool is_stale = frame_buffer->tile_epochs[t] != frame_buffer->epoch;
+        for (int y = tile.y0; y < tile.y1; y++)
+        {
+            for (int x = tile.x0; x < tile.x1; x++)
+            {
+                size_t i = (size_t) y * frame_buffer->width + x;
+                Vec3f rgb = is_stale ? frame_buffer->clear_color : unpack_color(frame_buffer->color[i], frame_buffer->color_format);
+                color->data[i * 3 + 0] = rgb.r;
+                color->data[i * 3 + 1] = rgb.g;
+                color->data[i * 3 + 2] = rgb.b;
+            }
+        }
+    }
+}
+
+RenderSettings render_settings;
+
+// Screen space polygon waiting in the bins to be rasterized
+struct BinnedPolygon
+{
+    int first_vertex, vertex_count;
+    const Texture* texture;
+};
+
+// Output of one geometry task, polygons and bins are kept in submission order
+struct GeometryBatch
+{
+    std::vector<Vertex> vertices;
+    std::vector<BinnedPolygon> polygons;
+    std::vector<std::vector<int>> bins; // polygon indices, one bin per tile
+    PipelineStats stats;
+};
+
+// Raster stage counters, one per worker, each on its own cache lines
+struct alignas(64) WorkerStats
+{
+    PipelineStats stats;
+};
+
+// Allocated once, reused every frame
+static std::vector<GeometryBatch> batches;
+static std::vector<Mat4x4f> model_views;
+static std::vector<BoundingVolume> object_bounds;
+static std::vector<CullResult> cull_results;
+static std::vector<int> drawn_objects; // scene object index of every object that survived culling
+static std::vector<int> face_offsets;  // indexed like drawn_objects
+static std::vector<int> vertex_offsets;
+static std::vector<WorkerStats> raster_stats;
+static PipelineStats frame_stats;
+
+// Post-transform vertex cache, structure-of-arrays, indexed by vertex_offsets[d] + mesh vertex index
+static std::vector<float> view_x, view_y, view_z;
+static std::vector<Outcode> outcodes; // bit p set when vertex is not strictly inside plane p
+
+const float CLIP_EPSILON = 0.001f; // same as cull_polygon's default
+
+/**
+ * Outcode planes, view space: the frustum (top, bottom, left, right, far, near) then the
+ * guard band's top, bottom, left, right. Faces are rejected against the frustum but only
+ * clipped against near, far and the guard band, the rasterizers already clip to the tile,
+ * so a face poking out of the screen (but not out of the guard band) goes through unclipped.
+ */
+const int OUTCODE_PLANE_COUNT = 10;
+const Outcode REJECT_MASK = 0x3F;
+const Outcode CLIP_MASK   = (1 << 4) | (1 << 5) | (0xF << 6);
+const float GUARD_BAND_SCALE = 4.0f; // guard band size in screens, keeps device coordinates small
+
+// Splits [0, count) into task_count contiguous ranges, returns the range of task
+static void get_task_range(int count, int task, int task_count, int& first, int& last)
+{
+    first = ((long long) count * task) / task_count;
+    last  = ((long long) count * (task + 1)) / task_count;
+}
+
+/**
+ * Face cull test for up to 4 triangles of one object, one triangle per lane, returns a bit per kept triangle.
+ * 
+ * In view space the camera sits at the origin, so a face looks at the camera when its normal
+ * points against any of its corners. Works on faces crossing the near plane too, so it runs
+ * before clipping.
+ */
+static int cull_faces(const Object& obj, int first_vertex, int f, int count)
+{
+    if (obj.face_cull_mode == FACE_CULL_NONE) return (1 << count) - 1;
+
+    float x[3][4] = {}, y[3][4] = {}, z[3][4] = {}; // unused lanes stay degenerate
+    const uint32_t* indices = obj.mesh->indices + f * 3;
+    for (int lane = 0; lane < count; lane++)
+    {
+        for (int c = 0; c < 3; c++)
+        {
+            int i = first_vertex + indices[lane * 3 + c];
+            x[c][lane] = view_x[i];
+            y[c][lane] = view_y[i];
+            z[c][lane] = view_z[i];
+        }
+    }
+
+    Float4 x0 = load_float4(x[0]), y0 = load_float4(y[0]), z0 = load_float4(z[0]);
+    Float4 e1_x = load_float4(x[1]) - x0, e1_y = load_float4(y[1]) - y0, e1_z = load_float4(z[1]) - z0;
+    Float4 e2_x = load_float4(x[2]) - x0, e2_y = load_float4(y[2]) - y0, e2_z = load_float4(z[2]) - z0;
+
+    Float4 normal_x = e1_y * e2_z - e1_z * e2_y;
+    Float4 normal_y = e1_z * e2_x - e1_x * e2_z;
+    Float4 normal_z = e1_x * e2_y - e1_y * e2_x;
+    Float4 facing = normal_x * x0 + normal_y * y0 + normal_z * z0;
+
+    // NOTE: edge-on faces (facing == 0) cover no pixels, both modes drop them
+    int kept = obj.face_cull_mode == FACE_CULL_BACK ? move_mask(cmp_lt(facing, float4(0.0f))) : move_mask(cmp_gt(facing, float4(0.0f)));
+    return kept & ((1 << count) - 1);
+}
+
+static void process_face(Scene& scene, int d, int f, const Plane* outcode_planes, const Mat4x4f& device, int tiles_x, int tiles_y, GeometryBatch& batch)
+{
+    Object& obj = scene.objects[drawn_objects[d]];
+    const uint32_t* triangle = obj.mesh->indices + f * 3;
+    int first = vertex_offsets[d];
+
+    // Outcodes decide most faces without clipping, all corners out past one frustum plane or none out of a clip plane
+    Outcode outcode_and = REJECT_MASK, outcode_or = 0;
+    for (int v = 0; v < 3; v++)
+    {
+        Outcode outcode = outcodes[first + triangle[v]];
+        outcode_and &= outcode;
+        outcode_or  |= outcode;
+    }
+    if (outcode_and)
+    {
+        batch.stats.faces_rejected++;
+        return;
+    }
+
+    ClipPolygon polygon;
+    polygon.count = 3;
+    for (int v = 0; v < 3; v++)
+    {
+        int i = first + triangle[v];
+        Vertex& vertex = polygon.vertices[v];
+        vertex.view = Vec3f(view_x[i], view_y[i], view_z[i]);
+        vertex.uv   = obj.mesh->uvs[triangle[v]];
+        vertex.cull = vertex.view;
+    }
+
+    if (outcode_or & CLIP_MASK)
+    {
+        clip_polygon(polygon, outcode_planes, OUTCODE_PLANE_COUNT, outcode_or & CLIP_MASK, CLIP_EPSILON);
+        batch.stats.polygons_clipped++;
+    }
+    if (polygon.count < 3)
+    {
+        batch.stats.faces_rejected++;
+        return;
+    }
+
+    Vec2f min_device ( std::numeric_limits<float>::max());
+    Vec2f max_device (-std::numeric_limits<float>::max());
+    for (int v = 0; v < polygon.count; v++)
+    {
+        Vertex& vertex = polygon.vertices[v];
+
+        Vec3f projected_pos = Vec3f((vertex.view.x / fabs(vertex.view.z)) * scene.camera.near, (vertex.view.y / fabs(vertex.view.z)) * scene.camera.near, vertex.view.z);
+        Vec3f device_pos = device * Vec4f(projected_pos, 1.0f);
+
+        vertex.device = device_pos.xy();
+        vertex.depth = device_pos.z;
+        vertex.cull = Vec3f(vertex.device.x, vertex.device.y, 0.0f); // So that rasterizer can cut up polygons into triangles
+
+        min_device = Vec2f(minf(min_device.x, vertex.device.x), minf(min_device.y, vertex.device.y));
+        max_device = Vec2f(maxf(max_device.x, vertex.device.x), maxf(max_device.y, vertex.device.y));
+    }
+
+    // Tiles overlapped by the polygon's bounding box
+    int tile_x0 = max_i(0, (int) floor(min_device.x) / TILE_SIZE);
+    int tile_y0 = max_i(0, (int) floor(min_device.y) / TILE_SIZE);
+    int tile_x1 = min_i(tiles_x - 1, (int) floor(max_device.x) / TILE_SIZE);
+    int tile_y1 = min_i(tiles_y - 1, (int) floor(max_device.y) / TILE_SIZE);
+    if (max_device.x < 0.0f || max_device.y < 0.0f || tile_x0 > tile_x1 || tile_y0 > tile_y1)
+    {
+        batch.stats.faces_rejected++;
+        return;
+    }
+    batch.stats.polygons_binned++;
+    batch.stats.triangles_binned += polygon.count - 2;
+    batch.stats.bin_entries += (tile_x1 - tile_x0 + 1) * (tile_y1 - tile_y0 + 1);
+
+    int index = batch.polygons.size();
+    batch.polygons.push_back(BinnedPolygon { (int) batch.vertices.size(), polygon.count, obj.texture });
+    batch.vertices.insert(batch.vertices.end(), polygon.vertices, polygon.vertices + polygon.count);
+
+    for (int ty = tile_y0; ty <= tile_y1; ty++)
+    {
+        for (int tx = tile_x0; tx <= tile_x1; tx++)
+        {
+            batch.bins[tx + ty * tiles_x].push_back(index);
+        }
+    }
+}
+
+/**
+ * PROCESS: (sort-middle)
+ * 
+ * cull, once per frame
+ *      test every object's bounding volumes against the frustum, 4 objects at a time
+ *      objects outside are dropped, objects inside skip outcodes and clipping
+ * 
+ * vertex, in parallel over contiguous ranges of vertices
+ *      transform every mesh vertex of every drawn object once, 8 at a time, into the vertex cache
+ *      along with its frustum outcode
+ * 
+ * geometry, in parallel over contiguous ranges of triangles
+ *      drop faces by the object's face cull mode, 4 faces at a time
+ *      gather face corners from the vertex cache, reject or accept faces by outcode
+ *      clip the rest against near, far and the guard band, project every face
+ *      bin resulting polygon into every screen tile its bounding box overlaps
+ * 
+ * raster, in parallel over screen tiles
+ *      clear the tile if it is behind the frame buffer's epoch (tiles with empty bins stay untouched)
+ *      rasterize and shade every polygon binned into the tile, clipped to the tile
+ * 
+ * A tile only ever touches its own pixels, and walks its bins in submission order,
+ * so the output is the same for any thread count (and needs no locks).
+ */
+void render_scene(Scene& scene, FrameBuffer* frame_buffer)
+{
+    ProfileScope cull_scope (STAGE_CULL, 0);
+    Mat4x4f camera = Mat4x4f::look_at(scene.camera.pos, scene.camera.dir, scene.camera.up);
+    Mat4x4f device = Mat4x4f::translation(Vec3f(frame_buffer->width/2.0f, frame_buffer->height/2.0f, 0.0f)) * Mat4x4f::scale(Vec3f(frame_buffer->width/scene.camera.aspect_ratio, frame_buffer->height, 1.0f)); // ASSUMPTION: virtual screen height is 1, and width is aspect-ratio
+
+    int tiles_x = frame_buffer->tiles_x;
+    int tiles_y = frame_buffer->tiles_y;
+    int tile_count = tiles_x * tiles_y;
+
+    // Depth is view z, -far to -near
+    frame_buffer->depth_scale = 1.0f / (scene.camera.far - scene.camera.near);
+    frame_buffer->depth_offset = scene.camera.far * frame_buffer->depth_scale;
+
+    // Planes are set up once per frame
+    Frustum frustum = get_frustum(scene.camera);
+    Frustum guard_band = frustum;
+    guard_band.l *= GUARD_BAND_SCALE;
+    guard_band.r *= GUARD_BAND_SCALE;
+    guard_band.t *= GUARD_BAND_SCALE;
+    guard_band.b *= GUARD_BAND_SCALE;
+
+    Plane outcode_planes[OUTCODE_PLANE_COUNT];
+    std::vector<Plane> frustum_planes = get_frustum_planes(frustum);
+    std::vector<Plane> guard_band_planes = get_frustum_planes(guard_band);
+    for (int p = 0; p < 6; p++) outcode_planes[p] = normalized_plane(frustum_planes[p]);
+    for (int p = 0; p < 4; p++) outcode_planes[6 + p] = normalized_plane(guard_band_planes[p]);
+
+    model_views.clear();
+    object_bounds.clear();
+    for (int o = 0; o < scene.objects.size(); o++)
+    {
+        Object& obj = scene.objects[o];
+        model_views.push_back(camera * scene.world * Mat4x4f::translation(obj.translation) * Mat4x4f::rotation_y(obj.yaw) * Mat4x4f::rotation_x(obj.pitch) * Mat4x4f::rotation_z(obj.roll) * Mat4x4f::scale(obj.scale));
+        object_bounds.push_back(obj.mesh->bounds);
+    }
+    cull_results.resize(scene.objects.size());
+    cull_objects(outcode_planes, 6, CLIP_EPSILON, model_views.data(), object_bounds.data(), scene.objects.size(), cull_results.data());
+
+    // Every vertex and face of a drawn object gets a global index, so they can be split evenly between tasks
+    drawn_objects.clear();
+    face_offsets.clear();
+    vertex_offsets.clear();
+    int face_count = 0, vertex_count = 0;
+    for (int o = 0; o < scene.objects.size(); o++)
+    {
+        if (cull_results[o] == CULL_OUTSIDE) continue;
+
+        Object& obj = scene.objects[o];
+        drawn_objects.push_back(o);
+        face_offsets.push_back(face_count);
+        vertex_offsets.push_back(vertex_count);
+        face_count += obj.mesh->triangle_count;
+        vertex_count += obj.mesh->vertex_count;
+    }
+    face_offsets.push_back(face_count);
+    vertex_offsets.push_back(vertex_count);
+    view_x.resize(vertex_count);
+    view_y.resize(vertex_count);
+    view_z.resize(vertex_count);
+    outcodes.resize(vertex_count);
+
+    int batch_count = get_worker_count();
+    if (batches.size() < batch_count) batches.resize(batch_count);
+    raster_stats.assign(batch_count, WorkerStats {});
+
+    frame_stats = PipelineStats {};
+    frame_stats.objects_submitted = scene.objects.size();
+    frame_stats.objects_culled = scene.objects.size() - drawn_objects.size();
+    frame_stats.faces_submitted = face_count;
+    frame_stats.pixel_count = (uint64_t) frame_buffer->width * frame_buffer->height;
+    cull_scope.end();
+
+    parallel_for(batch_count, [&](int b, int worker)
+    {
+        int first_vertex, last_vertex;
+        get_task_range(vertex_count, b, batch_count, first_vertex, last_vertex);
+        if (first_vertex == last_vertex) return;
+        ProfileScope scope (STAGE_VERTEX, worker);
+
+        // Range can span several objects, each object's part is one contiguous run
+        int d = std::upper_bound(vertex_offsets.begin(), vertex_offsets.end(), first_vertex) - vertex_offsets.begin() - 1;
+        for (int vertex = first_vertex; vertex < last_vertex; d++)
+        {
+            int o = drawn_objects[d];
+            int run_end = min_i(last_vertex, vertex_offsets[d + 1]);
+            int local = vertex - vertex_offsets[d];
+            Mesh* mesh = scene.objects[o].mesh;
+            int plane_count = cull_results[o] == CULL_INSIDE ? 0 : OUTCODE_PLANE_COUNT; // no planes, all outcodes come out 0
+            transform_vertices(
+                model_views[o], 
+                mesh->positions_x + local, mesh->positions_y + local, mesh->positions_z + local, run_end - vertex,
+                outcode_planes, plane_count, CLIP_EPSILON,
+                view_x.data() + vertex, view_y.data() + vertex, view_z.data() + vertex, outcodes.data() + vertex
+            );
+            vertex = run_end;
+        }
+    });
+
+    parallel_for(batch_count, [&](int b, int worker)
+    {
+        ProfileScope scope (STAGE_CLIP, worker);
+        GeometryBatch& batch = batches[b];
+        batch.stats = PipelineStats {};
+        batch.vertices.clear();
+        batch.polygons.clear();
+        batch.bins.resize(tile_count);
+        for (int t = 0; t < tile_count; t++) batch.bins[t].clear();
+
+        int first_face, last_face;
+        get_task_range(face_count, b, batch_count, first_face, last_face);
+        if (first_face == last_face) return;
+
+        // Faces go through the cull test 4 at a time, a group never spans two objects
+        int d = std::upper_bound(face_offsets.begin(), face_offsets.end(), first_face) - face_offsets.begin() - 1;
+        for (int face = first_face; face < last_face; )
+        {
+            while (face >= face_offsets[d + 1]) d++;
+            int local = face - face_offsets[d];
+            int count = min_i(4, min_i(last_face, face_offsets[d + 1]) - face);
+
+            int kept = cull_faces(scene.objects[drawn_objects[d]], vertex_offsets[d], local, count);
+            batch.stats.faces_backface_culled += count - __builtin_popcount(kept);
+            for (int i = 0; i < count; i++)
+            {
+                if (kept & (1 << i)) process_face(scene, d, local + i, outcode_planes, device, tiles_x, tiles_y, batch);
+            }
+            face += count;
+        }
+    });
+
+    parallel_for(tile_count, [&](int t, int worker)
+    {
+        int polygon_count = 0;
+        for (int b = 0; b < batch_count; b++) polygon_count += batches[b].bins[t].size();
+        if (polygon_count == 0) return; // left stale when it is, still reads as cleared
+
+        ProfileScope scope (STAGE_RASTER, worker);
+        PipelineStats& stats = raster_stats[worker].stats;
+        prepare_tile(t, worker, frame_buffer);
+        Rect tile = get_tile_rect(t, frame_buffer);
+        for (int b = 0; b < batch_count; b++)
+        {
+            GeometryBatch& batch = batches[b];
+            for (int i = 0; i < batch.bins[t].size(); i++)
+            {
+                BinnedPolygon& poly = batch.polygons[batch.bins[t][i]];
+                const Vertex* vertices = &batch.vertices[poly.first_vertex];
+
+                ShadeFragment shade { frame_buffer, poly.texture, render_settings.texture_filter, &stats };
+                if (render_settings.raster_mode == RASTER_HALF_SPACE) stats.triangles_rasterized += rasterize_polygon_half_space(vertices, poly.vertex_count, tile, shade);
+                else                                                  stats.triangles_rasterized += rasterize_polygon(vertices, poly.vertex_count, tile, shade);
+            }
+        }
+    });
+
+    for (int b = 0; b < batch_count; b++)
+    {
+        add_pipeline_stats(batches[b].stats, frame_stats);
+        add_pipeline_stats(raster_stats[b].stats, frame_stats);
+    }
+}
+
+PipelineStats get_pipeline_stats()
+{
+    return frame_stats;
+}
+
+void set_fragment(Fragment& frag, FrameBuffer* frame_buffer, const Texture* texture)
+{
+    bool is_out_of_bounds = (frag.pixel.x < 0 || frag.pixel.x >= frame_buffer->width) || (frag.pixel.y < 0 || frag.pixel.y >= frame_buffer->height);
+    if (is_out_of_bounds) return;
+
+    prepare_tile((frag.pixel.x / TILE_SIZE) + (frag.pixel.y / TILE_SIZE) * frame_buffer->tiles_x, 0, frame_buffer);
+    PipelineStats stats = {}; // not counted in any frame
+    ShadeFragment shade { frame_buffer, texture, render_settings.texture_filter, &stats };
+    shade(frag.pixel.x, frag.pixel.y, frag.depth, frag.uv);
+}
+
+Buffer* tga_image_to_buffer(TGAImage& img)
+{
+    Buffer* buffer = new Buffer();
+    init_buffer(img.get_width(), img.get_height(), 3, buffer);
+
+    for (int y = 0; y < img.get_height(); y++)
+    {
+        for (int x = 0; x < img.get_width(); x++)
+        {
+            TGAColor tga_color = img.get(x, y);
+            Vec3f rgb (tga_color.r / 255.0f, tga_color.g / 255.0f, tga_color.b / 255.0f);
+            set_element(x, y, rgb.raw, buffer);
+        }
+    }
+
+    return buffer;
+}
+
+// Buffer has (0,0) as bottom left, TGA image has (0,0) as top left
+TGAImage buffer_to_tga_image(Buffer* buffer)
+{
+    TGAImage img (buffer->width, buffer->height, TGAImage::RGB);
+
+    for (int y = 0; y < buffer->height; y++)
+    {
+        for (int x = 0; x < buffer->width; x++)
+        {
+            Vec3f rgb; get_element(x, y, rgb.raw, buffer);
+            rgb = clampedVec3f(rgb, 0.0f, 1.0f);
+            img.set(x, buffer->height - 1 - y, TGAColor(rgb.r * 255.9999f, rgb.g * 255.9999f, rgb.b * 255.9999f, 255));
+        }
+    }
+
+    return img;
+}
@@ -0,0 +1,180 @@
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "Scale.h"
+#include "Simd.h"
+#include "Profiler.h"
+#include "Util.h"
+#include "WorkerPool.h"
+
+const int SCALE_ROWS_PER_TASK = 16;
+
+// Source taps of one target column (or row), blended as a * (1 - weight) + b * weight
+struct ScaleTap
+{
+    int a, b;
+    float weight;
+};
+
+// Allocated once, reused every call
+static std::vector<ScaleTap> column_taps, row_taps;
+static std::vector<std::vector<float>> scratch_rows; // per worker, 2 horizontally filtered rows of 4 floats per pixel
+
+// Target pixel centers mapped onto source pixel centers, edges clamped
+static void get_taps(int src_size, int target_size, std::vector<ScaleTap>& taps)
+{
+    taps.resize(target_size);
+    float scale = (float) src_size / target_size;
+    for (int i = 0; i < target_size; i++)
+    {
+        float position = (i + 0.5f) * scale - 0.5f;
+        int floor_position = (int) std::floor(position);
+        taps[i].weight = position - floor_position;
+        taps[i].a = clampi(floor_position,     0, src_size - 1);
+        taps[i].b = clampi(floor_position + 1, 0, src_size - 1);
+    }
+}
+
+// Writes 3 of the 4 lanes, the 4th would land on the next element
+static inline void store_rgb(float* p, Float4 rgb)
+{
+    float lanes[4];
+    store_float4(lanes, rgb);
+    p[0] = lanes[0];
+    p[1] = lanes[1];
+    p[2] = lanes[2];
+}
+
+// ASSUMPTION: loads of the last element read Buffer's padding float, lane 3 is never stored
+static void filter_row_horizontal(const float* src_row, int width, float* out)
+{
+    for (int i = 0; i < width; i++)
+    {
+        const ScaleTap& tap = column_taps[i];
+        Float4 a = load_float4(src_row + tap.a * 3), b = load_float4(src_row + tap.b * 3);
+        store_float4(out + i * 4, a + (b - a) * float4(tap.weight));
+    }
+}
+
+static void scale_bilinear(const Buffer* src, Buffer* target, int x, int y, int width, int first_row, int last_row, int worker)
+{
+    std::vector<float>& scratch = scratch_rows[worker];
+    scratch.resize(width * 8);
+    float* filtered[2] = { scratch.data(), scratch.data() + width * 4 };
+    int filtered_rows[2] = { -1, -1 };
+
+    for (int j = first_row; j < last_row; j++)
+    {
+        const ScaleTap& tap = row_taps[j];
+
+        // Neighbouring target rows mostly share their source rows, each one is filtered once
+        int needed[2] = { tap.a, tap.b };
+        for (int k = 0; k < 2; k++)
+        {
+            if (filtered_rows[k] == needed[k]) continue;
+            if (k == 0 && filtered_rows[1] == needed[0])
+            {
+                // Moving down a row, the old bottom row is the new top one
+                std::swap(filtered[0], filtered[1]);
+                std::swap(filtered_rows[0], filtered_rows[1]);
+                continue;
+            }
+            filter_row_horizontal(src->data + (size_t) needed[k] * src->width * 3, width, filtered[k]);
+            filtered_rows[k] = needed[k];
+        }
+
+        float* out = target->data + ((size_t) (y + j) * target->width + x) * 3;
+        Float4 weight = float4(tap.weight);
+        for (int i = 0; i < width; i++)
+        {
+            Float4 a = load_float4(filtered[0] + i * 4), b = load_float4(filtered[1] + i * 4);
+            Float4 rgb = a + (b - a) * weight;
+            if (i + 1 < width) store_float4(out + i * 3, rgb); // the 4th lane is overwritten by the next pixel
+            else               store_rgb(out + i * 3, rgb);
+        }
+    }
+}
+
+// Target is factor times the source, every source pixel becomes a factor x factor block
+static void scale_repeat(const Buffer* src, Buffer* target, int x, int y, int width, int factor, int first_row, int last_row)
+{
+    for (int j = first_row; j < last_row; j++)
+    {
+        float* out = target->data + ((size_t) (y + j) * target->width + x) * 3;
+        if (j != first_row && j % factor != 0)
+        {
+            memcpy(out, out - (size_t) target->width * 3, width * 3 * sizeof(float));
+            continue;
+        }
+
+        const float* src_row = src->data + (size_t) (j / factor) * src->width * 3;
+        for (int i = 0; i < width; i++)
+        {
+            const float* pixel = src_row + (i / factor) * 3;
+            out[i * 3 + 0] = pixel[0];
+            out[i * 3 + 1] = pixel[1];
+            out[i * 3 + 2] = pixel[2];
+        }
+    }
+}
+
+// Source is factor times the target, every target pixel is the average of a factor x factor block
+static void scale_box(const Buffer* src, Buffer* target, int x, int y, int width, int factor, int first_row, int last_row)
+{
+    Float4 one_over_count = float4(1.0f / (factor * factor));
+    for (int j = first_row; j < last_row; j++)
+    {
+        float* out = target->data + ((size_t) (y + j) * target->width + x) * 3;
+        for (int i = 0; i < width; i++)
+        {
+            Float4 sum = float4(0.0f);
+            for (int sy = 0; sy < factor; sy++)
+            {
+                const float* src_row = src->data + ((size_t) (j * factor + sy) * src->width + i * factor) * 3;
+                for (int sx = 0; sx < factor; sx++) sum = sum + load_float4(src_row + sx * 3);
+            }
+            store_rgb(out + i * 3, sum * one_over_count);
+        }
+    }
+}
+
+void scale_buffer(const Buffer* src, Buffer* target, int x, int y, int width, int height)
+{
+    assert(src->fpp == 3 && target->fpp == 3);
+
+    // Clipped part of the region, taps still come from the whole region
+    int x0 = max_i(x, 0), y0 = max_i(y, 0);
+    int x1 = min_i(x + width, target->width), y1 = min_i(y + height, target->height);
+    if (x0 >= x1 || y0 >= y1 || src->width < 1 || src->height < 1) return;
+
+    bool is_repeat = width % src->width == 0 && height % src->height == 0 && width / src->width == height / src->height;
+    bool is_box    = src->width % width == 0 && src->height % height == 0 && src->width / width == src->height / height;
+    bool is_clipped = x0 != x || y0 != y || x1 != x + width || y1 != y + height;
+    if (is_clipped) is_repeat = is_box = false; // ROBUSTNESS: fast paths assume the whole region
+
+    if (!is_repeat && !is_box)
+    {
+        get_taps(src->width, width, column_taps);
+        get_taps(src->height, height, row_taps);
+        if (scratch_rows.size() < get_worker_count()) scratch_rows.resize(get_worker_count());
+
+        // Taps are shifted so the clipped region starts at 0
+        column_taps.erase(column_taps.begin(), column_taps.begin() + (x0 - x));
+        row_taps.erase(row_taps.begin(), row_taps.begin() + (y0 - y));
+    }
+
+    int factor = is_repeat ? width / src->width : src->width / width;
+    int row_count = y1 - y0;
+    int task_count = (row_count + SCALE_ROWS_PER_TASK - 1) / SCALE_ROWS_PER_TASK;
+    parallel_for(task_count, [&](int task, int worker)
+    {
+        ProfileScope scope (STAGE_BLIT, worker);
+        int first_row = task * SCALE_ROWS_PER_TASK;
+        int last_row = min_i(first_row + SCALE_ROWS_PER_TASK, row_count);
+        if      (is_repeat) scale_repeat(src, target, x0, y0, x1 - x0, factor, first_row, last_row);
+        else if (is_box)    scale_box(src, target, x0, y0, x1 - x0, factor, first_row, last_row);
+        else                scale_bilinear(src, target, x0, y0, x1 - x0, first_row, last_row, worker);
+    });
+}
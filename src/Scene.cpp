@@ -0,0 +1,245 @@
+#include "Scene.h"
+#include "Renderer.h"
+#include "Util.h"
+#include "Pack.h"
+#include "tgaimage.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+
+// Baked assets (make pack) are used when the pack is there, source assets otherwise
+static const char* ASSET_PACK = "bin/assets.pack";
+
+const float STRESS_NEAR_DEPTH = 2.0f;  // object centers, the camera's near plane is at 1
+const float STRESS_FAR_DEPTH = 20.0f;
+const float STRESS_MAX_TILT = 0.35f;   // radians of yaw and pitch, either way
+const int STRESS_TEXTURE_SIZE = 256;
+
+// NOTE: stays mapped for the rest of the program, like the meshes and textures it hands out
+static Pack asset_pack;
+static bool is_asset_pack_open = false;
+
+// Name of the first source asset edited after the pack was baked, nullptr when the pack is current
+static const char* find_newer_source(const Pack* pack, const char* filename)
+{
+    struct stat pack_stat;
+    if (stat(filename, &pack_stat) != 0) return nullptr;
+
+    struct stat source_stat;
+    for (const char* name : pack->mesh_names)
+        if (stat(name, &source_stat) == 0 && source_stat.st_mtime > pack_stat.st_mtime) return name;
+    for (const char* name : pack->texture_names)
+        if (stat(name, &source_stat) == 0 && source_stat.st_mtime > pack_stat.st_mtime) return name;
+    return nullptr;
+}
+
+static void open_asset_pack()
+{
+    if (is_asset_pack_open || !std::ifstream(ASSET_PACK).good()) return;
+    if (!open_pack(ASSET_PACK, &asset_pack)) return;
+
+    // ROBUSTNESS: a stale pack would silently hide edits to obj/ and img/, so the sources win
+    if (const char* source = find_newer_source(&asset_pack, ASSET_PACK))
+    {
+        std::cerr << "Warning:: " << source << " is newer than " << ASSET_PACK << ", using source assets (run make pack)" << std::endl;
+        close_pack(&asset_pack);
+        return;
+    }
+    is_asset_pack_open = true;
+}
+
+static Mesh* load_mesh(const char* filename)
+{
+    Mesh* mesh = is_asset_pack_open ? find_pack_mesh(&asset_pack, filename) : nullptr;
+    return mesh ? mesh : new Mesh(filename);
+}
+
+// Eight textured cubes arranged as a 2x2x2 rubik's cube around the origin
+void init_rubik_scene(Scene& scene)
+{
+    scene.world = Mat4x4f::identity_matrix();
+    open_asset_pack();
+    init_texture_manager(DEFAULT_TEXTURE_BUDGET, is_asset_pack_open ? &asset_pack : nullptr, &scene.textures);
+
+    Object cube;
+    cube.yaw = radians(0.0f);
+    cube.pitch = radians(0.0f);
+    cube.roll = radians(0.0f);
+    cube.scale = Vec3f(1.0f, 1.0f, 1.0f);
+    cube.mesh = load_mesh("obj/cube.obj");
+    cube.texture = nullptr;
+
+    cube.translation = Vec3f(0.5f, -0.5f, 0.5f); // front-right bottom
+    scene.objects.push_back(cube);
+
+    cube.translation = Vec3f(-0.5f, -0.5f, 0.5f); // front-left bottom
+    scene.objects.push_back(cube);
+
+    cube.translation = Vec3f(-0.5f, -0.5f, -0.5f); // back-left bottom
+    scene.objects.push_back(cube);
+
+    cube.translation = Vec3f(0.5f, -0.5f, -0.5f); // back-right bottom
+    scene.objects.push_back(cube);
+
+    cube.translation = Vec3f(0.5f, 0.5f, 0.5f); // front-right top
+    scene.objects.push_back(cube);
+
+    cube.translation = Vec3f(-0.5f, 0.5f, 0.5f); // front-left top
+    scene.objects.push_back(cube);
+
+    cube.translation = Vec3f(-0.5f, 0.5f, -0.5f); // back-left top
+    scene.objects.push_back(cube);
+
+    cube.translation = Vec3f(0.5f, 0.5f, -0.5f); // back-right top
+    scene.objects.push_back(cube);
+
+    for (int i = 0; i < scene.objects.size(); i++) scene.objects[i].texture = acquire_texture("img/Cubie_Face_Red.tga", &scene.textures);
+}
+
+// Same sequence for the same seed on every platform, unlike the std distributions
+static uint32_t next_random(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+static float random_float(uint32_t& state, float min, float max)
+{
+    return min + (max - min) * (next_random(state) / 16777216.0f);
+}
+
+// Cells of a grid mesh, about square
+static void get_grid_size(int triangle_count, int& columns, int& rows)
+{
+    int cell_count = (triangle_count + 1) / 2;
+    columns = std::ceil(std::sqrt((float) cell_count));
+    rows = (cell_count + columns - 1) / columns;
+}
+
+// Grid of square cells centered on the origin in the xy-plane, facing +z, two triangles a cell
+// (the last cell gets one for an odd count), uv spans the whole grid
+static Mesh* make_grid_mesh(int triangle_count, float cell_size)
+{
+    int columns, rows;
+    get_grid_size(triangle_count, columns, rows);
+
+    Mesh* mesh = new Mesh();
+    MeshStorage& storage = mesh->storage;
+    for (int y = 0; y <= rows; y++)
+    {
+        for (int x = 0; x <= columns; x++)
+        {
+            storage.vertices.push_back(Vec3f((x - columns * 0.5f) * cell_size, (y - rows * 0.5f) * cell_size, 0.0f));
+            storage.uvs.push_back(Vec2f((float) x / columns, (float) y / rows));
+            storage.normals.push_back(Vec3f(0.0f, 0.0f, 1.0f));
+        }
+    }
+
+    for (int t = 0; t < triangle_count; t++)
+    {
+        int cell = t / 2;
+        uint32_t a = (cell % columns) + (cell / columns) * (columns + 1), b = a + 1, c = a + columns + 1, d = c + 1;
+        uint32_t triangle[3] = { a, b, d };
+        if (t % 2) triangle[1] = d, triangle[2] = c;
+        storage.indices.insert(storage.indices.end(), triangle, triangle + 3);
+    }
+
+    mesh->update_from_storage();
+    return mesh;
+}
+
+// Two random colors in squares of 8 to 64 texels, tiled with its full mip chain
+static Texture* make_checker_texture(uint32_t& state)
+{
+    uint8_t colors[2][4];
+    for (int c = 0; c < 2; c++)
+    {
+        for (int i = 0; i < 3; i++) colors[c][i] = next_random(state) & 0xFF;
+        colors[c][3] = 255;
+    }
+    int check_size = 8 << (next_random(state) % 4);
+
+    Texture* texture = new Texture();
+    init_texture(STRESS_TEXTURE_SIZE, STRESS_TEXTURE_SIZE, TEXTURE_RGBA8, TEXTURE_TILED, 1, texture);
+    uint8_t* texels = get_writable_level(0, texture);
+    for (int y = 0; y < STRESS_TEXTURE_SIZE; y++)
+    {
+        for (int x = 0; x < STRESS_TEXTURE_SIZE; x++)
+        {
+            const uint8_t* color = colors[((x / check_size) + (y / check_size)) & 1];
+            memcpy(texels + get_texel_index(x, y, STRESS_TEXTURE_SIZE, TEXTURE_TILED) * TEXTURE_RGBA8, color, 4);
+        }
+    }
+
+    build_mip_levels(texture);
+    return texture;
+}
+
+void init_stress_scene(const StressSceneSettings& settings, Scene& scene)
+{
+    // ROBUSTNESS
+    int object_count = max_i(settings.object_count, 1);
+    int triangle_count = max_i(settings.triangles_per_object, 1);
+    int texture_count = max_i(settings.texture_count, 1);
+    float min_size = maxf(settings.min_triangle_size, 1e-4f);
+    float max_size = maxf(settings.max_triangle_size, min_size);
+    float depth_complexity = maxf(settings.depth_complexity, 0.01f);
+
+    Camera& camera = scene.camera;
+    camera.pos = Vec3f(0.0f, 0.0f, 0.0f);
+    camera.dir = Vec3f(0.0f, 0.0f, -1.0f);
+    camera.up = Vec3f(0.0f, 1.0f, 0.0f);
+    camera.yaw = radians(180.0f);
+    camera.pitch = radians(90.0f);
+    camera.near = 1.0f;
+    camera.far = STRESS_FAR_DEPTH * 1.5f; // room for tilted and big objects behind the farthest center
+    scene.world = Mat4x4f::identity_matrix();
+    scene.objects.clear();
+
+    uint32_t state = settings.seed;
+    init_texture_manager(DEFAULT_TEXTURE_BUDGET, nullptr, &scene.textures);
+    std::vector<Texture*> textures;
+    for (int i = 0; i < texture_count; i++)
+    {
+        std::string path = "stress/checker_" + std::to_string(settings.seed) + "_" + std::to_string(i);
+        textures.push_back(add_texture(path.c_str(), make_checker_texture(state), &scene.textures));
+    }
+
+    // Sizes first, the region the objects go in follows from their summed area
+    std::vector<float> cell_sizes (object_count);
+    float total_area = 0.0f;
+    for (int i = 0; i < object_count; i++)
+    {
+        cell_sizes[i] = min_size * std::pow(max_size / min_size, random_float(state, 0.0f, 1.0f));
+        total_area += triangle_count * cell_sizes[i] * cell_sizes[i] * 0.5f;
+    }
+    float region_height = std::sqrt(total_area / depth_complexity / camera.aspect_ratio);
+    float region_width = region_height * camera.aspect_ratio;
+    int columns, rows;
+    get_grid_size(triangle_count, columns, rows);
+
+    // Mesh is built at its on-screen size for depth 1, scaling by the depth keeps that size at the depth
+    for (int i = 0; i < object_count; i++)
+    {
+        float depth = random_float(state, STRESS_NEAR_DEPTH, STRESS_FAR_DEPTH);
+
+        // Whole object inside the region, whichever way it is spun
+        float radius = std::sqrt((float) (columns * columns + rows * rows)) * cell_sizes[i] * 0.5f;
+        float x = random_float(state, -1.0f, 1.0f) * maxf(region_width * 0.5f - radius, 0.0f);
+        float y = random_float(state, -1.0f, 1.0f) * maxf(region_height * 0.5f - radius, 0.0f);
+
+        Object object;
+        object.translation = Vec3f(x * depth, y * depth, -depth);
+        object.scale = Vec3f(depth, depth, depth);
+        object.yaw = random_float(state, -STRESS_MAX_TILT, STRESS_MAX_TILT);
+        object.pitch = random_float(state, -STRESS_MAX_TILT, STRESS_MAX_TILT);
+        object.roll = random_float(state, 0.0f, radians(360.0f));
+        object.mesh = make_grid_mesh(triangle_count, cell_sizes[i]);
+        object.texture = textures[i % texture_count];
+        object.face_cull_mode = FACE_CULL_NONE; // flat, both sides show
+        scene.objects.push_back(object);
+    }
+}
@@ -0,0 +1,386 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include "Texture.h"
+#include "Pack.h"
+#include "Util.h"
+
+void init_texture(int width, int height, TextureFormat format, TextureLayout layout, int level_count, Texture* texture)
+{
+    texture->format = format;
+    texture->layout = layout;
+    texture->level_count = min_i(max_i(level_count, 1), get_full_level_count(width, height));
+
+    for (int level = 0; level < texture->level_count; level++)
+    {
+        texture->levels[level] = TextureLevel { nullptr, width, height };
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    // Levels start on cache lines, so a tiled RGBA8 block never straddles two
+    size_t size = 0;
+    for (int level = 0; level < texture->level_count; level++)
+    {
+        size += get_level_size(texture->levels[level].width, texture->levels[level].height, format, layout);
+        size = (size + TEXTURE_ALIGNMENT - 1) & ~(TEXTURE_ALIGNMENT - 1);
+    }
+    texture->storage.assign(size + TEXTURE_ALIGNMENT - 1, 0);
+
+    uint8_t* data = texture->storage.data() + (-(uintptr_t) texture->storage.data() & (TEXTURE_ALIGNMENT - 1));
+    for (int level = 0; level < texture->level_count; level++)
+    {
+        TextureLevel& texels = texture->levels[level];
+        texels.data = data;
+        data += get_level_size(texels.width, texels.height, format, layout);
+        data += -(uintptr_t) data & (TEXTURE_ALIGNMENT - 1);
+    }
+}
+
+// Levels view storage read-only, the texture's own functions fill them through here
+uint8_t* get_writable_level(int level, Texture* texture)
+{
+    return texture->storage.data() + (texture->levels[level].data - texture->storage.data());
+}
+
+int get_full_level_count(int width, int height)
+{
+    int level_count = 1;
+    while ((width > 1 || height > 1) && level_count < MAX_TEXTURE_LEVELS)
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        level_count++;
+    }
+    return level_count;
+}
+
+size_t get_level_size(int width, int height, TextureFormat format, TextureLayout layout)
+{
+    if (layout == TEXTURE_TILED)
+    {
+        width = (width + TEXTURE_BLOCK_MASK) & ~TEXTURE_BLOCK_MASK;
+        height = (height + TEXTURE_BLOCK_MASK) & ~TEXTURE_BLOCK_MASK;
+    }
+    return (size_t) width * height * format;
+}
+
+size_t get_texture_size(const Texture* texture)
+{
+    size_t size = 0;
+    for (int level = 0; level < texture->level_count; level++)
+    {
+        size += get_level_size(texture->levels[level].width, texture->levels[level].height, texture->format, texture->layout);
+    }
+    return size;
+}
+
+// Replaces the texture's levels past level 0 with the full chain, box filtered, odd edges repeat their last texel
+void build_mip_levels(Texture* texture)
+{
+    const TextureLevel& first = texture->levels[0];
+    Texture full;
+    init_texture(first.width, first.height, texture->format, texture->layout, MAX_TEXTURE_LEVELS, &full);
+    memcpy(get_writable_level(0, &full), first.data, get_level_size(first.width, first.height, texture->format, texture->layout));
+
+    int channel_count = texture->format;
+    for (int level = 1; level < full.level_count; level++)
+    {
+        const TextureLevel& source = full.levels[level - 1];
+        const TextureLevel& target = full.levels[level];
+        uint8_t* out = get_writable_level(level, &full);
+
+        for (int y = 0; y < target.height; y++)
+        {
+            int y0 = min_i(y * 2, source.height - 1), y1 = min_i(y * 2 + 1, source.height - 1);
+            for (int x = 0; x < target.width; x++)
+            {
+                int x0 = min_i(x * 2, source.width - 1), x1 = min_i(x * 2 + 1, source.width - 1);
+                const uint8_t* texels[4] = {
+                    source.data + get_texel_index(x0, y0, source.width, full.layout) * channel_count,
+                    source.data + get_texel_index(x1, y0, source.width, full.layout) * channel_count,
+                    source.data + get_texel_index(x0, y1, source.width, full.layout) * channel_count,
+                    source.data + get_texel_index(x1, y1, source.width, full.layout) * channel_count
+                };
+                uint8_t* texel = out + get_texel_index(x, y, target.width, full.layout) * channel_count;
+                for (int i = 0; i < channel_count; i++) texel[i] = (texels[0][i] + texels[1][i] + texels[2][i] + texels[3][i] + 2) / 4;
+            }
+        }
+    }
+
+    // NOTE: swapping keeps the level pointers valid, they follow the vector's buffer
+    texture->storage.swap(full.storage);
+    texture->level_count = full.level_count;
+    for (int level = 0; level < full.level_count; level++) texture->levels[level] = full.levels[level];
+}
+
+void set_texture_layout(TextureLayout layout, Texture* texture)
+{
+    if (texture->layout == layout) return;
+
+    Texture reordered;
+    init_texture(texture->levels[0].width, texture->levels[0].height, texture->format, layout, texture->level_count, &reordered);
+
+    int channel_count = texture->format;
+    for (int level = 0; level < texture->level_count; level++)
+    {
+        const TextureLevel& source = texture->levels[level];
+        uint8_t* out = get_writable_level(level, &reordered);
+        for (int y = 0; y < source.height; y++)
+        {
+            for (int x = 0; x < source.width; x++)
+            {
+                memcpy(out + get_texel_index(x, y, source.width, layout) * channel_count,
+                       source.data + get_texel_index(x, y, source.width, texture->layout) * channel_count, channel_count);
+            }
+        }
+    }
+
+    texture->storage.swap(reordered.storage);
+    texture->layout = layout;
+    for (int level = 0; level < texture->level_count; level++) texture->levels[level] = reordered.levels[level];
+}
+
+Texture* tga_image_to_texture(TGAImage& img)
+{
+    bool is_grey = img.get_bytespp() == TGAImage::GRAYSCALE;
+    Texture* texture = new Texture();
+    init_texture(img.get_width(), img.get_height(), is_grey ? TEXTURE_R8 : TEXTURE_RGBA8, TEXTURE_TILED, 1, texture);
+    uint8_t* texels = get_writable_level(0, texture);
+
+    for (int y = 0; y < img.get_height(); y++)
+    {
+        for (int x = 0; x < img.get_width(); x++)
+        {
+            TGAColor tga_color = img.get(x, y);
+            uint8_t* texel = texels + get_texel_index(x, y, img.get_width(), TEXTURE_TILED) * texture->format;
+            if (is_grey)
+            {
+                texel[0] = tga_color.raw[0];
+                continue;
+            }
+
+            texel[0] = tga_color.r;
+            texel[1] = tga_color.g;
+            texel[2] = tga_color.b;
+            texel[3] = img.get_bytespp() == TGAImage::RGBA ? tga_color.a : 255;
+        }
+    }
+
+    build_mip_levels(texture);
+    return texture;
+}
+
+float get_texture_lod(const Texture* texture, float du_dx, float dv_dx, float du_dy, float dv_dy)
+{
+    float width = texture->levels[0].width, height = texture->levels[0].height;
+    float x_length = (du_dx * width) * (du_dx * width) + (dv_dx * height) * (dv_dx * height);
+    float y_length = (du_dy * width) * (du_dy * width) + (dv_dy * height) * (dv_dy * height);
+
+    // Texels per pixel along the more stretched direction, log2 of the square root
+    float length = maxf(x_length, y_length);
+    return length > 0.0f ? 0.5f * std::log2(length) : 0.0f;
+}
+
+// Texel as floats, 0 to 255
+static Float4 get_texel(size_t index, const TextureLevel& level, TextureFormat format)
+{
+    const uint8_t* texel = level.data + index * format;
+    if (format == TEXTURE_RGBA8) return load_bytes4(texel);
+    return float4(texel[0], texel[0], texel[0], 255.0f);
+}
+
+// uv will be clamped
+Float4 sample_nearest(float u, float v, int level, const Texture* texture)
+{
+    assert(u >= -0.5f && u <= 1.5f);
+    assert(v >= -0.5f && v <= 1.5f);
+    assert(level >= 0 && level < texture->level_count);
+
+    u = clampf(u, 0.0f, 1.0f); // ROBUSTNESS
+    v = clampf(v, 0.0f, 1.0f);
+
+    const TextureLevel& texels = texture->levels[level];
+    int x = clampi(u * texels.width, 0, texels.width - 1);
+    int y = clampi(v * texels.height, 0, texels.height - 1);
+
+    return get_texel(get_texel_index(x, y, texels.width, texture->layout), texels, texture->format) * float4(1.0f / 255.0f);
+}
+
+// uv will be clamped, texel centers are at (i + 0.5) / size, edges clamp
+Float4 sample_bilinear(float u, float v, int level, const Texture* texture)
+{
+    assert(u >= -0.5f && u <= 1.5f);
+    assert(v >= -0.5f && v <= 1.5f);
+    assert(level >= 0 && level < texture->level_count);
+
+    u = clampf(u, 0.0f, 1.0f); // ROBUSTNESS
+    v = clampf(v, 0.0f, 1.0f);
+
+    const TextureLevel& texels = texture->levels[level];
+    float x = u * texels.width - 0.5f, y = v * texels.height - 0.5f;
+
+    // NOTE: x and y are at least -0.5, truncating them past 0 is floor without a libm call
+    int x_floor = (int) (x + 1.0f) - 1, y_floor = (int) (y + 1.0f) - 1;
+    float fx = x - x_floor, fy = y - y_floor;
+
+    size_t column0 = get_texel_column_index(max_i(x_floor, 0), texture->layout);
+    size_t column1 = get_texel_column_index(min_i(x_floor + 1, texels.width - 1), texture->layout);
+    size_t row0 = get_texel_row_index(max_i(y_floor, 0), texels.width, texture->layout);
+    size_t row1 = get_texel_row_index(min_i(y_floor + 1, texels.height - 1), texels.width, texture->layout);
+
+    // Weights carry the byte to 0 to 1 scale, so it is one multiply per texel
+    const float SCALE = 1.0f / 255.0f;
+    Float4 sample = get_texel(row0 + column0, texels, texture->format) * float4((1.0f - fx) * (1.0f - fy) * SCALE)
+                  + get_texel(row0 + column1, texels, texture->format) * float4(fx * (1.0f - fy) * SCALE)
+                  + get_texel(row1 + column0, texels, texture->format) * float4((1.0f - fx) * fy * SCALE)
+                  + get_texel(row1 + column1, texels, texture->format) * float4(fx * fy * SCALE);
+    return sample;
+}
+
+// lod is clamped to the levels there are, blends bilinear samples of the two nearest levels
+Float4 sample_trilinear(float u, float v, float lod, const Texture* texture)
+{
+    lod = clampf(lod, 0.0f, texture->level_count - 1);
+    int level = lod;
+    float t = lod - level;
+    if (t <= 0.0f) return sample_bilinear(u, v, level, texture);
+
+    return sample_bilinear(u, v, level, texture) * float4(1.0f - t) + sample_bilinear(u, v, level + 1, texture) * float4(t);
+}
+
+// Nearest and bilinear take the level closest to lod
+Float4 sample_texture(float u, float v, float lod, TextureFilter filter, const Texture* texture)
+{
+    if (filter == FILTER_TRILINEAR) return sample_trilinear(u, v, lod, texture);
+
+    int level = clampi(lod + 0.5f, 0, texture->level_count - 1);
+    if (filter == FILTER_BILINEAR) return sample_bilinear(u, v, level, texture);
+    return sample_nearest(u, v, level, texture);
+}
+
+void init_texture_manager(size_t budget, Pack* pack, TextureManager* manager)
+{
+    manager->entries.clear();
+    manager->pack = pack;
+    manager->budget = budget;
+    manager->size = 0;
+    manager->release_count = 0;
+}
+
+void destroy_texture_manager(TextureManager* manager)
+{
+    for (int i = 0; i < manager->entries.size(); i++)
+    {
+        if (manager->entries[i].is_owned) delete manager->entries[i].texture;
+    }
+    manager->entries.clear();
+    manager->size = 0;
+}
+
+// Evicts unreferenced textures, least recently released first, until extra_size more fits the budget
+static void make_room(size_t extra_size, TextureManager* manager)
+{
+    while (manager->budget > 0 && manager->size + extra_size > manager->budget)
+    {
+        int oldest = -1;
+        for (int i = 0; i < manager->entries.size(); i++)
+        {
+            const TextureEntry& entry = manager->entries[i];
+            if (entry.ref_count == 0 && (oldest < 0 || entry.last_release < manager->entries[oldest].last_release)) oldest = i;
+        }
+        if (oldest < 0) return;
+
+        TextureEntry& entry = manager->entries[oldest];
+        manager->size -= get_texture_size(entry.texture);
+        if (entry.is_owned) delete entry.texture;
+        manager->entries.erase(manager->entries.begin() + oldest);
+    }
+}
+
+void set_texture_budget(size_t budget, TextureManager* manager)
+{
+    manager->budget = budget;
+    make_room(0, manager);
+}
+
+// 1x1 magenta, stands in for a texture that failed to load so renderers never see a null texture
+static Texture* make_missing_texture()
+{
+    static const uint8_t MAGENTA[4] = { 255, 0, 255, 255 };
+
+    Texture* texture = new Texture();
+    init_texture(1, 1, TEXTURE_RGBA8, TEXTURE_TILED, 1, texture);
+    memcpy(get_writable_level(0, texture), MAGENTA, sizeof(MAGENTA));
+    return texture;
+}
+
+Texture* acquire_texture(const char* path, TextureManager* manager)
+{
+    for (int i = 0; i < manager->entries.size(); i++)
+    {
+        TextureEntry& entry = manager->entries[i];
+        if (entry.path != path) continue;
+
+        entry.ref_count++;
+        return entry.texture;
+    }
+
+    TextureEntry entry { path, nullptr, 1, 0, false };
+    entry.texture = manager->pack ? find_pack_texture(manager->pack, path) : nullptr;
+    if (!entry.texture)
+    {
+        TGAImage tga_image;
+        if (tga_image.read_tga_file(path))
+        {
+            entry.texture = tga_image_to_texture(tga_image);
+        }
+        else
+        {
+            std::cerr << "Error:: could not load texture " << path << ", using a magenta placeholder\n";
+            entry.texture = make_missing_texture();
+        }
+        entry.is_owned = true;
+    }
+
+    size_t size = get_texture_size(entry.texture);
+    make_room(size, manager);
+    if (manager->budget > 0 && manager->size + size > manager->budget)
+    {
+        std::cerr << "Error:: texture budget of " << manager->budget << " bytes exceeded by " << path << ", loading it anyway\n";
+    }
+
+    manager->size += size;
+    manager->entries.push_back(entry);
+    return entry.texture;
+}
+
+Texture* add_texture(const char* path, Texture* texture, TextureManager* manager)
+{
+    size_t size = get_texture_size(texture);
+    make_room(size, manager);
+    if (manager->budget > 0 && manager->size + size > manager->budget)
+    {
+        std::cerr << "Error:: texture budget of " << manager->budget << " bytes exceeded by " << path << ", adding it anyway\n";
+    }
+
+    manager->size += size;
+    manager->entries.push_back(TextureEntry { path, texture, 1, 0, true });
+    return texture;
+}
+
+void release_texture(Texture* texture, TextureManager* manager)
+{
+    for (int i = 0; i < manager->entries.size(); i++)
+    {
+        TextureEntry& entry = manager->entries[i];
+        if (entry.texture != texture) continue;
+
+        assert(entry.ref_count > 0);
+        entry.ref_count--;
+        if (entry.ref_count == 0) entry.last_release = ++manager->release_count;
+        make_room(0, manager);
+        return;
+    }
+}
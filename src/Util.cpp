@@ -1,12 +1,6 @@
 #include "Util.h"
 #include <cassert>
 
-float clampf(float f, float min, float max)
-{
-    assert(min <= max);
-    return f < min ? min : f > max ? max : f;
-}
-
 float clampi(int i, int min, int max)
 {
     assert(min <= max);
@@ -19,26 +13,6 @@ float lerpf(float a, float b, float t)
     return a * (1.0f - t) + b * t;
 }
 
-float maxf(float a, float b)
-{
-    return a > b ? a : b;
-}
-
-float minf(float a, float b)
-{
-    return a < b ? a : b;
-}
-
-int min_i(int a, int b)
-{
-    return a < b ? a : b;
-}
-
-int max_i(int a, int b)
-{
-    return a > b ? a : b;
-}
-
 float radians(float degree)
 {
     return degree * (3.14159265358979f / 180.0f);
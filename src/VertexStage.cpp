@@ -0,0 +1,125 @@
+#include <cassert>
+#include "VertexStage.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAS_AVX_KERNEL
+#include <immintrin.h>
+#endif
+
+// Reference path, also handles the tail the SIMD path leaves over
+// NOTE: same operation order as the AVX path, so both give the same bits
+static void transform_vertices_scalar(
+    const Mat4x4f& m, 
+    const float* x, const float* y, const float* z, int first, int count,
+    const Plane* planes, int plane_count, float epsilon,
+    float* out_x, float* out_y, float* out_z, Outcode* outcodes
+)
+{
+    for (int i = first; i < count; i++)
+    {
+        float vx = ((m.mat[0][0] * x[i] + m.mat[0][1] * y[i]) + m.mat[0][2] * z[i]) + m.mat[0][3];
+        float vy = ((m.mat[1][0] * x[i] + m.mat[1][1] * y[i]) + m.mat[1][2] * z[i]) + m.mat[1][3];
+        float vz = ((m.mat[2][0] * x[i] + m.mat[2][1] * y[i]) + m.mat[2][2] * z[i]) + m.mat[2][3];
+
+        Outcode outcode = 0;
+        for (int p = 0; p < plane_count; p++)
+        {
+            float distance = ((planes[p].a * vx + planes[p].b * vy) + planes[p].c * vz) + planes[p].d;
+            if (distance <= epsilon) outcode |= (1 << p);
+        }
+
+        out_x[i] = vx;
+        out_y[i] = vy;
+        out_z[i] = vz;
+        outcodes[i] = outcode;
+    }
+}
+
+#ifdef HAS_AVX_KERNEL
+
+// Compiled for AVX regardless of the build flags, only called when the CPU supports it
+__attribute__((target("avx")))
+static int transform_vertices_avx(
+    const Mat4x4f& m, 
+    const float* x, const float* y, const float* z, int count,
+    const Plane* planes, int plane_count, float epsilon,
+    float* out_x, float* out_y, float* out_z, Outcode* outcodes
+)
+{
+    __m256 row[3][4];
+    for (int r = 0; r < 3; r++)
+    {
+        for (int c = 0; c < 4; c++) row[r][c] = _mm256_set1_ps(m.mat[r][c]);
+    }
+
+    __m256 plane_a[MAX_OUTCODE_PLANES], plane_b[MAX_OUTCODE_PLANES], plane_c[MAX_OUTCODE_PLANES], plane_d[MAX_OUTCODE_PLANES], plane_bit[MAX_OUTCODE_PLANES];
+    for (int p = 0; p < plane_count; p++)
+    {
+        plane_a[p] = _mm256_set1_ps(planes[p].a);
+        plane_b[p] = _mm256_set1_ps(planes[p].b);
+        plane_c[p] = _mm256_set1_ps(planes[p].c);
+        plane_d[p] = _mm256_set1_ps(planes[p].d);
+        plane_bit[p] = _mm256_set1_ps((float) (1 << p));
+    }
+    __m256 eps = _mm256_set1_ps(epsilon);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 pz = _mm256_loadu_ps(z + i);
+
+        __m256 v[3];
+        for (int r = 0; r < 3; r++)
+        {
+            v[r] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(row[r][0], px), _mm256_mul_ps(row[r][1], py)), _mm256_mul_ps(row[r][2], pz)), row[r][3]);
+        }
+
+        _mm256_storeu_ps(out_x + i, v[0]);
+        _mm256_storeu_ps(out_y + i, v[1]);
+        _mm256_storeu_ps(out_z + i, v[2]);
+
+        // Outcode bits are summed up as floats, then packed down to 16 bits
+        __m256 code = _mm256_setzero_ps();
+        for (int p = 0; p < plane_count; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_a[p], v[0]), _mm256_mul_ps(plane_b[p], v[1])), _mm256_mul_ps(plane_c[p], v[2])), plane_d[p]);
+            __m256 is_not_inside = _mm256_cmp_ps(distance, eps, _CMP_LE_OQ);
+            code = _mm256_add_ps(code, _mm256_and_ps(is_not_inside, plane_bit[p]));
+        }
+        __m256i code_int = _mm256_cvttps_epi32(code);
+        __m128i code_16 = _mm_packs_epi32(_mm256_castsi256_si128(code_int), _mm256_extractf128_si256(code_int, 1)); // NOTE: signed saturation, fine below 15 planes
+        _mm_storeu_si128((__m128i*) (outcodes + i), code_16);
+    }
+
+    return i;
+}
+
+static bool cpu_has_avx()
+{
+    static bool has_avx = __builtin_cpu_supports("avx");
+    return has_avx;
+}
+
+#endif
+
+void transform_vertices(
+    const Mat4x4f& model_view, 
+    const float* x, const float* y, const float* z, int count,
+    const Plane* planes, int plane_count, float epsilon,
+    float* out_x, float* out_y, float* out_z, Outcode* outcodes
+)
+{
+    assert(plane_count <= MAX_OUTCODE_PLANES);
+    assert(model_view.mat[3][0] == 0.0f && model_view.mat[3][1] == 0.0f && model_view.mat[3][2] == 0.0f && model_view.mat[3][3] == 1.0f);
+
+    int done = 0;
+#ifdef HAS_AVX_KERNEL
+    if (cpu_has_avx())
+    {
+        done = transform_vertices_avx(model_view, x, y, z, count, planes, plane_count, epsilon, out_x, out_y, out_z, outcodes);
+    }
+#endif
+    transform_vertices_scalar(model_view, x, y, z, done, count, planes, plane_count, epsilon, out_x, out_y, out_z, outcodes);
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include "Window.h"
+#include "Present.h"
 #include <cmath>
 
 Window window;
@@ -44,32 +45,39 @@ void resize_window(int width, int height)
     SDL_SetSurfaceBlendMode(window.draw_surface, SDL_BLENDMODE_NONE); // no blending
 }
 
-// Assumes rgba are all in [0,1]
-int to_rgb_int(float* rgb)
+// Byte order of window surfaces the frame can be written straight into
+static bool get_pixel_order(SDL_PixelFormat format, PixelOrder& order)
 {
-    int r_int = (rgb[0] * 255.9999f);
-    int g_int = (rgb[1] * 255.9999f);
-    int b_int = (rgb[2] * 255.9999f);
-
-    int result = (0xFF << 24) | (b_int << 16) | (g_int << 8) | r_int;
-    return result;
+    switch (format)
+    {
+        case SDL_PIXELFORMAT_RGBA32: case SDL_PIXELFORMAT_RGBX32: order = PIXEL_RGBA; return true;
+        case SDL_PIXELFORMAT_BGRA32: case SDL_PIXELFORMAT_BGRX32: order = PIXEL_BGRA; return true;
+        default: return false;
+    }
 }
 
 // Assumes pixels is same size as global window.
 // Note, SDL has top left as (0,0), but input should have (0,0) as bottom left
-void blit_window(float *pixels)
+void blit_window(float* pixels, bool is_srgb)
 {
-    int pixel_count = window.width * window.height;
-    int offset = pixel_count;
-    for (int i = 0; i < pixel_count; i++)
-    {
-        if (i % window.width == 0) offset -= window.width;
-        int mapped_index = offset + (i % window.width);
+    SDL_Surface* surface = SDL_GetWindowSurface(window.handle);
+    PixelOrder order;
+    bool is_direct = surface && surface->w == window.width && surface->h == window.height && get_pixel_order(surface->format, order);
 
-        window.pixels[mapped_index] = to_rgb_int(&pixels[i * 3]);
+    if (is_direct)
+    {
+        // Converted straight into the window surface, no second copy
+        bool must_lock = SDL_MUSTLOCK(surface);
+        if (must_lock && !SDL_LockSurface(surface)) return;
+        present_pixels(pixels, is_srgb, PresentTarget { (uint8_t*) surface->pixels, window.width, window.height, surface->pitch, order });
+        if (must_lock) SDL_UnlockSurface(surface);
+    }
+    else
+    {
+        present_pixels(pixels, is_srgb, PresentTarget { (uint8_t*) window.pixels, window.width, window.height, window.width * 4, PIXEL_RGBA });
+        SDL_BlitSurface(window.draw_surface, NULL, surface, NULL);
     }
 
-    SDL_BlitSurface(window.draw_surface, NULL, SDL_GetWindowSurface(window.handle), NULL);
     SDL_UpdateWindowSurface(window.handle);
 }
 
@@ -151,6 +159,9 @@ void poll_events()
                     case SDLK_RIGHT:
                         window.input.keys[KEY_RIGHT].is_down = true;
                         break;
+                    case SDLK_P:
+                        window.input.keys[KEY_P].is_down = true;
+                        break;
                 }
                 break;
             case SDL_EVENT_KEY_UP:
@@ -177,6 +188,9 @@ void poll_events()
                     case SDLK_RIGHT:
                         window.input.keys[KEY_RIGHT].is_down = false;
                         break;
+                    case SDLK_P:
+                        window.input.keys[KEY_P].is_down = false;
+                        break;
                 }
                 break;
         }
@@ -0,0 +1,112 @@
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "WorkerPool.h"
+
+struct WorkerPool
+{
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+
+    const ParallelTask* task = nullptr;
+    int task_count = 0;
+    std::atomic<int> next_task { 0 };
+
+    int busy_workers = 0;
+    int generation = 0; // bumped for every parallel_for call, wakes the workers
+    bool is_running = false;
+    bool shutting_down = false;
+};
+
+static WorkerPool pool;
+
+static void run_tasks(int worker)
+{
+    int task;
+    while ((task = pool.next_task.fetch_add(1)) < pool.task_count)
+    {
+        (*pool.task)(task, worker);
+    }
+}
+
+static void worker_loop(int worker)
+{
+    int seen_generation = 0;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock (pool.mutex);
+        pool.work_ready.wait(lock, [&] { return pool.shutting_down || pool.generation != seen_generation; });
+        if (pool.shutting_down) return;
+        seen_generation = pool.generation;
+        lock.unlock();
+
+        run_tasks(worker);
+
+        lock.lock();
+        pool.busy_workers--;
+        if (pool.busy_workers == 0) pool.work_done.notify_one();
+    }
+}
+
+// thread_count includes the calling thread, so 1 means run everything serially
+void init_worker_pool(int thread_count)
+{
+    assert(pool.threads.empty());
+
+    for (int i = 1; i < thread_count; i++)
+    {
+        pool.threads.push_back(std::thread(worker_loop, i));
+    }
+}
+
+void destroy_worker_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock (pool.mutex);
+        pool.shutting_down = true;
+    }
+    pool.work_ready.notify_all();
+
+    for (int i = 0; i < pool.threads.size(); i++) pool.threads[i].join();
+    pool.threads.clear();
+    pool.shutting_down = false;
+}
+
+int get_worker_count()
+{
+    return pool.threads.size() + 1;
+}
+
+void parallel_for(int task_count, const ParallelTask& task)
+{
+    assert(!pool.is_running);
+
+    if (pool.threads.empty() || task_count <= 1)
+    {
+        for (int i = 0; i < task_count; i++) task(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (pool.mutex);
+        pool.task = &task;
+        pool.task_count = task_count;
+        pool.next_task = 0;
+        pool.busy_workers = pool.threads.size();
+        pool.generation++;
+        pool.is_running = true;
+    }
+    pool.work_ready.notify_all();
+
+    run_tasks(0);
+
+    std::unique_lock<std::mutex> lock (pool.mutex);
+    pool.work_done.wait(lock, [] { return pool.busy_workers == 0; });
+    pool.is_running = false;
+}
@@ -1,23 +1,28 @@
 #include <SDL3/SDL.h>
 #include <iostream>
 #include <chrono>
+#include <thread>
 #include <cmath>
 #include <vector>
 #include "Window.h"
 #include "Vec.h"
-#include "Rasterize.h"
-#include "Mesh.h"
 #include "Mat.h"
-#include "Camera.h"
-#include "Object.h"
-#include "Geometry.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include "WorkerPool.h"
 #include "Buffer.h"
+#include "Scale.h"
+#include "DynamicResolution.h"
+#include "Profiler.h"
 #include "Util.h"
 #include <cassert>
 
 struct Actions
 {
     bool cycle_resolution = false;
+    bool toggle_dynamic_resolution = false;
+    bool dump_profile = false;
+    bool cycle_raster_mode = false;
     bool update_mouse_pos = false;
     bool exit_program = false;
     bool resize_window = false;
@@ -28,13 +33,6 @@ struct Actions
     bool move_camera_right = false;
 } input_actions;
 
-struct FrameBuffer
-{
-    Buffer* color;
-    Buffer* depth;
-    int width, height;
-};
-
 struct ProgramState
 {
     bool running = true;
@@ -43,28 +41,34 @@ struct ProgramState
     float dt = 0;
 
     FrameBuffer* render_buffer = nullptr;
-    FrameBuffer* screen_res_buffer = nullptr;
+    Buffer* resolve_buffer = nullptr;    // render buffer's color as floats, blit source
+    Buffer* screen_res_buffer = nullptr; // window sized, only ever blitted into
     int resolution_scale_index = 3;
+    bool is_dynamic_resolution = true; // render scale follows the controller, Enter goes back to the fixed scalers
+    ResolutionController resolution;
 
     Vec2f mouse_pos;
-    Camera camera;
-    std::vector<Object> objects;
+    Scene scene;
 
     Vec3f rubik_euler_angles;
 } state;
 
 const int RESOLUTION_SCALERS_COUNT = 6;
 const float RESOLUTION_SCALERS[RESOLUTION_SCALERS_COUNT] = { 0.125f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f };
+const float RENDER_BUDGET_MS = 16.6f;
+const float MIN_DYNAMIC_SCALE = 0.25f;
+const float MAX_DYNAMIC_SCALE = 1.0f;
+const float VIEW_INSET = 0.1f; // render is scaled into the window leaving a border this fraction of it wide
 const Vec3f CLEAR_COLOR (0.0f, 0.0f, 0.0f);
+const ColorFormat COLOR_FORMAT = COLOR_RGBA8;
+const DepthFormat DEPTH_FORMAT = DEPTH_32F;
 
 void update();
 void draw();
 void handle_events();
 void handle_time();
 void init();
-
-Buffer* tga_image_to_buffer(TGAImage& img);
-void set_fragment(Fragment& frag, Buffer* color_buffer, Buffer* depth_buffer, Buffer* texture);
+void resize_render_buffer();
 
 int main()
 {
@@ -83,65 +87,29 @@ void init()
 {
     int width = 640, height = 480;
     init_window(width, height);
+    init_worker_pool(std::thread::hardware_concurrency());
+    init_profiler(get_worker_count());
+    set_profiling(true);
 
-    state.screen_res_buffer = new FrameBuffer();
+    state.screen_res_buffer = new Buffer();
+    state.resolve_buffer = new Buffer();
     state.render_buffer = new FrameBuffer();
-    state.render_buffer->color = new Buffer();
-    state.render_buffer->depth = new Buffer();
-    state.screen_res_buffer->color = new Buffer();
-    state.screen_res_buffer->depth = new Buffer();
-    state.screen_res_buffer->width = width;
-    state.screen_res_buffer->height = height;
-    state.render_buffer->width = width;
-    state.render_buffer->height = height;
-    init_buffer(width, height, 3, state.render_buffer->color);
-    init_buffer(width, height, 1, state.render_buffer->depth);
-    init_buffer(width, height, 3, state.screen_res_buffer->color);
-    init_buffer(width, height, 1, state.screen_res_buffer->depth);
-
-    state.camera.up = Vec3f(0.0f, 1.0f, 0.0f);
-    state.camera.pos = Vec3f(0.0f, 0.0f, 5.0f);
-    state.camera.aspect_ratio = ((float) width) / ((float) height);
-    state.camera.near = 1.0f;
-    state.camera.far = 25.0f;
-    state.camera.dir = Vec3f(0.0f, 0.0f, -1.0f);
-    state.camera.yaw = radians(180.0f);
-    state.camera.pitch = radians(90.0f);
-
-    TGAImage tga_image;
-    tga_image.read_tga_file("img/Cubie_Face_Red.tga");
-
-    Object cube;
-    cube.yaw = radians(0.0f);
-    cube.pitch = radians(0.0f);
-    cube.roll = radians(0.0f);
-    cube.scale = Vec3f(1.0f, 1.0f, 1.0f);
-    cube.mesh = new Mesh("obj/cube.obj");
-    cube.texture = tga_image_to_buffer(tga_image);
-
-    cube.translation = Vec3f(0.5f, -0.5f, 0.5f); // front-right bottom
-    state.objects.push_back(cube);
-
-    cube.translation = Vec3f(-0.5f, -0.5f, 0.5f); // front-left bottom
-    state.objects.push_back(cube);
-
-    cube.translation = Vec3f(-0.5f, -0.5f, -0.5f); // back-left bottom
-    state.objects.push_back(cube);
-
-    cube.translation = Vec3f(0.5f, -0.5f, -0.5f); // back-right bottom
-    state.objects.push_back(cube);
-
-    cube.translation = Vec3f(0.5f, 0.5f, 0.5f); // front-right top
-    state.objects.push_back(cube);
-
-    cube.translation = Vec3f(-0.5f, 0.5f, 0.5f); // front-left top
-    state.objects.push_back(cube);
-
-    cube.translation = Vec3f(-0.5f, 0.5f, -0.5f); // back-left top
-    state.objects.push_back(cube);
-
-    cube.translation = Vec3f(0.5f, 0.5f, -0.5f); // back-right top
-    state.objects.push_back(cube);
+    init_buffer(width, height, 3, state.screen_res_buffer);
+    init_buffer(width, height, 3, state.resolve_buffer);
+    init_frame_buffer(width, height, COLOR_FORMAT, DEPTH_FORMAT, state.render_buffer);
+    init_resolution_controller(RENDER_BUDGET_MS, MIN_DYNAMIC_SCALE, MAX_DYNAMIC_SCALE, &state.resolution);
+    resize_render_buffer();
+
+    state.scene.camera.up = Vec3f(0.0f, 1.0f, 0.0f);
+    state.scene.camera.pos = Vec3f(0.0f, 0.0f, 5.0f);
+    state.scene.camera.aspect_ratio = ((float) width) / ((float) height);
+    state.scene.camera.near = 1.0f;
+    state.scene.camera.far = 25.0f;
+    state.scene.camera.dir = Vec3f(0.0f, 0.0f, -1.0f);
+    state.scene.camera.yaw = radians(180.0f);
+    state.scene.camera.pitch = radians(90.0f);
+
+    init_rubik_scene(state.scene);
 }
 
 void handle_time()
@@ -161,6 +129,9 @@ void handle_events()
 
     // Map user input to commands
     input_actions.cycle_resolution = (window.input.keys[KEY_ENTER].is_down && !window.input.keys[KEY_ENTER].prev_state);
+    input_actions.toggle_dynamic_resolution = (window.input.keys[KEY_A].is_down && !window.input.keys[KEY_A].prev_state);
+    input_actions.dump_profile = (window.input.keys[KEY_P].is_down && !window.input.keys[KEY_P].prev_state);
+    input_actions.cycle_raster_mode = (window.input.keys[KEY_SPACE].is_down && !window.input.keys[KEY_SPACE].prev_state);
     input_actions.update_mouse_pos = (window.input.mouse.did_move);
     input_actions.exit_program = (window.input.quit);
     input_actions.resize_window = (window.input.window.did_resize);
@@ -171,90 +142,56 @@ void handle_events()
     input_actions.move_camera_right = window.input.keys[KEY_RIGHT].is_down;
 }
 
-void render_scene(FrameBuffer* frame_buffer)
-{
-    static std::vector<Fragment> fragments (1000);
-    fragments.clear();
-
-    Mat4x4f camera = Mat4x4f::look_at(state.camera.pos, state.camera.dir, state.camera.up);
-    Mat4x4f device = Mat4x4f::translation(Vec3f(frame_buffer->width/2.0f, frame_buffer->height/2.0f, 0.0f)) * Mat4x4f::scale(Vec3f(frame_buffer->width/state.camera.aspect_ratio, frame_buffer->height, 1.0f)); // ASSUMPTION: virtual screen height is 1, and width is aspect-ratio
-    Mat4x4f world  = Mat4x4f::identity_matrix();
-    Mat4x4f rubik  = Mat4x4f::rotation_y(state.rubik_euler_angles.y) * Mat4x4f::rotation_x(state.rubik_euler_angles.x) * Mat4x4f::rotation_z(state.rubik_euler_angles.z);
-
-    for (int o = 0; o < state.objects.size(); o++)
-    {
-        Object& obj   = state.objects[o];
-        Mat4x4f local = rubik * Mat4x4f::translation(obj.translation) * Mat4x4f::rotation_y(obj.yaw) * Mat4x4f::rotation_x(obj.pitch) * Mat4x4f::rotation_z(obj.roll) * Mat4x4f::scale(obj.scale);
-
-        for (int f = 0; f < obj.mesh->faces.size(); f++)
-        {
-            std::vector<int> face = obj.mesh->faces[f];
-            std::vector<Vertex> vertices;
-            int vertex_count = face.size() / 2; // ASSUMPTION: 2 attributes per vertex (local pos, uv)
-            for (int v = 0; v < vertex_count; v++)
-            {
-                Vec3f local_pos = obj.mesh->vertices[face[v * 2]];
-                Vec2f uv = obj.mesh->uvs[face[v * 2 + 1]];
-
-                Vertex vertex;
-                vertex.world = world * local * Vec4f(local_pos, 1.0f);
-                vertex.view  = camera * Vec4f(vertex.world, 1.0f);
-                vertex.uv    = uv;
-                vertex.cull  = vertex.view;
-
-                vertices.push_back(vertex);
-            }
-
-            std::vector<Plane> frustum_planes = get_frustum_planes(get_frustum(state.camera));
-            for (int p = 0; p < frustum_planes.size(); p++)
-            {
-                std::vector<Vertex> in, out;
-                cull_polygon(vertices, frustum_planes[p], in, out);
-                vertices = in;
-            }
-
-            for (int v = 0; v < vertices.size(); v++)
-            {
-                Vertex& vertex = vertices[v];
-
-                Vec3f projected_pos = Vec3f((vertex.view.x / fabs(vertex.view.z)) * state.camera.near, (vertex.view.y / fabs(vertex.view.z)) * state.camera.near, vertex.view.z);
-                Vec3f device_pos = device * Vec4f(projected_pos, 1.0f);
-
-                vertex.device = device_pos.xy();
-                vertex.depth = device_pos.z;
-                vertex.cull = Vec3f(vertex.device.x, vertex.device.y, 0.0f); // So that rasterizer can cut up polygons into triangles
-            }
-
-            rasterize_polygon(vertices, frame_buffer->height, frame_buffer->width, fragments);
-
-            for (int i = 0; i < fragments.size(); i++)
-            {
-                set_fragment(fragments[i], frame_buffer->color, frame_buffer->depth, obj.texture);
-            }
-            fragments.clear();
-        }
-    }
-}
-
 void draw()
 {
     Vec3f BLACK (0.0f);
     Vec3f BLUEISH (0.1f, 0.1f, 0.2f * sin(SDL_GetTicks() * 0.0005f) + 0.5f);
     Vec3f YELLOW (0.5f, 0.7f, 0.0f);
 
+    ProfileScope frame_scope (STAGE_FRAME, 0);
+
     // Clear and render into render buffer
-    clear_buffer(BLUEISH.raw, state.render_buffer->color);
-    clear_buffer(&MAX_DEPTH, state.render_buffer->depth);
-    render_scene(state.render_buffer);
+    clear_frame_buffer(BLUEISH, state.render_buffer);
+    auto render_start = std::chrono::steady_clock::now();
+    render_scene(state.scene, state.render_buffer);
+    float render_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - render_start).count();
+    resolve_frame_buffer(state.render_buffer, state.resolve_buffer);
 
     // Clear and blit onto screen res buffer
-    Vec2f offset (0.1 * state.screen_res_buffer->width, 0.1 * state.screen_res_buffer->height);
-    clear_buffer(YELLOW.raw, state.screen_res_buffer->color);
-    clear_buffer(&MAX_DEPTH, state.screen_res_buffer->depth);
-    blit_buffer(state.render_buffer->color, state.screen_res_buffer->color, offset.x, offset.y, 0.8f, 0.8f);
+    Vec2f offset (VIEW_INSET * state.screen_res_buffer->width, VIEW_INSET * state.screen_res_buffer->height);
+    Vec2f size ((1.0f - 2.0f * VIEW_INSET) * state.screen_res_buffer->width, (1.0f - 2.0f * VIEW_INSET) * state.screen_res_buffer->height);
+    {
+        ProfileScope scope (STAGE_CLEAR, 0);
+        clear_buffer(YELLOW.raw, state.screen_res_buffer);
+    }
+    scale_buffer(state.resolve_buffer, state.screen_res_buffer, offset.x, offset.y, size.x, size.y);
 
     // Blit onto window
-    blit_window(state.screen_res_buffer->color->data);
+    blit_window(state.screen_res_buffer->data);
+
+    // New scale takes effect next frame
+    if (state.is_dynamic_resolution && update_resolution_controller(render_ms, &state.resolution)) resize_render_buffer();
+
+    frame_scope.end();
+    end_profiler_frame();
+}
+
+// Render resolution is the scaled size of the window's view (the part inside the inset)
+// NOTE: with scalers of 1/n or n the view is a whole multiple, so scale_buffer takes its integer path
+void resize_render_buffer()
+{
+    float scale = state.is_dynamic_resolution ? state.resolution.scale : RESOLUTION_SCALERS[state.resolution_scale_index];
+    int view_width = (int) ((1.0f - 2.0f * VIEW_INSET) * window.width);
+    int view_height = (int) ((1.0f - 2.0f * VIEW_INSET) * window.height);
+
+    // Storage for the largest dynamic scale is allocated up front, so the controller's changes never allocate
+    reserve_frame_buffer(view_width * MAX_DYNAMIC_SCALE, view_height * MAX_DYNAMIC_SCALE, state.render_buffer);
+    reserve_buffer(view_width * MAX_DYNAMIC_SCALE, view_height * MAX_DYNAMIC_SCALE, state.resolve_buffer);
+
+    int render_width = max_i(1, view_width * scale);
+    int render_height = max_i(1, view_height * scale);
+    resize_frame_buffer(render_width, render_height, state.render_buffer);
+    resize_buffer(render_width, render_height, state.resolve_buffer);
 }
 
 void update()
@@ -262,6 +199,7 @@ void update()
     state.rubik_euler_angles.y += 0.015f;
     state.rubik_euler_angles.x = radians(7.0f) * sin(SDL_GetTicks() * 0.003f);
     state.rubik_euler_angles.z = 0.0f;
+    state.scene.world = Mat4x4f::rotation_y(state.rubik_euler_angles.y) * Mat4x4f::rotation_x(state.rubik_euler_angles.x) * Mat4x4f::rotation_z(state.rubik_euler_angles.z);
 
     // state.objects[0].pitch += 0.01f;
     // state.objects[0].yaw += 0.025f;
@@ -278,36 +216,49 @@ void update()
         resize_window(window.input.window.new_width, window.input.window.new_height);
 
         // Update screen resolution buffer
-        state.screen_res_buffer->width = window.input.window.new_width;
-        state.screen_res_buffer->height = window.input.window.new_height;
-        resize_buffer(window.input.window.new_width, window.input.window.new_height, state.screen_res_buffer->color);
-        resize_buffer(window.input.window.new_width, window.input.window.new_height, state.screen_res_buffer->depth);
+        resize_buffer(window.input.window.new_width, window.input.window.new_height, state.screen_res_buffer);
 
         // Update render buffer
-        state.render_buffer->width = window.input.window.new_width * RESOLUTION_SCALERS[state.resolution_scale_index];
-        state.render_buffer->height = window.input.window.new_height * RESOLUTION_SCALERS[state.resolution_scale_index];
-        resize_buffer(window.input.window.new_width * RESOLUTION_SCALERS[state.resolution_scale_index], window.input.window.new_height * RESOLUTION_SCALERS[state.resolution_scale_index], state.render_buffer->color);
-        resize_buffer(window.input.window.new_width * RESOLUTION_SCALERS[state.resolution_scale_index], window.input.window.new_height * RESOLUTION_SCALERS[state.resolution_scale_index], state.render_buffer->depth);
+        resize_render_buffer();
         
         // Update camera aspect ratio
-        state.camera.aspect_ratio = ((float) window.input.window.new_width) / ((float) window.input.window.new_height);
+        state.scene.camera.aspect_ratio = ((float) window.input.window.new_width) / ((float) window.input.window.new_height);
     }
 
     if (input_actions.update_mouse_pos)
     {
         Vec2f mouse_pos = Vec2f(window.input.mouse.pos.x, window.height - window.input.mouse.pos.y);
-        map_sample_point(mouse_pos.raw, state.screen_res_buffer->color, state.render_buffer->color, state.mouse_pos.raw);
+        map_sample_point(mouse_pos.raw, state.screen_res_buffer, state.resolve_buffer, state.mouse_pos.raw);
     }
 
     if (input_actions.cycle_resolution)
     {
         state.resolution_scale_index = (state.resolution_scale_index + 1) % RESOLUTION_SCALERS_COUNT;
+        state.is_dynamic_resolution = false;
 
         // Update render buffer
-        state.render_buffer->width = window.width * RESOLUTION_SCALERS[state.resolution_scale_index];
-        state.render_buffer->height = window.height * RESOLUTION_SCALERS[state.resolution_scale_index];
-        resize_buffer(window.width * RESOLUTION_SCALERS[state.resolution_scale_index], window.height * RESOLUTION_SCALERS[state.resolution_scale_index], state.render_buffer->color);
-        resize_buffer(window.width * RESOLUTION_SCALERS[state.resolution_scale_index], window.height * RESOLUTION_SCALERS[state.resolution_scale_index], state.render_buffer->depth);
+        resize_render_buffer();
+    }
+
+    if (input_actions.toggle_dynamic_resolution)
+    {
+        state.is_dynamic_resolution = !state.is_dynamic_resolution;
+        resize_render_buffer();
+    }
+
+    if (input_actions.dump_profile)
+    {
+        print_profile();
+        write_chrome_trace("profile.json");
+
+        PipelineStats stats = get_pipeline_stats();
+        std::cout << "last frame: " << stats.faces_submitted << " faces, " << stats.triangles_rasterized << " triangles rasterized, "
+                  << stats.fragments_generated << " fragments, overdraw " << get_frame_overdraw(stats) << "\n";
+    }
+
+    if (input_actions.cycle_raster_mode)
+    {
+        render_settings.raster_mode = (render_settings.raster_mode == RASTER_SCANLINE) ? RASTER_HALF_SPACE : RASTER_SCANLINE;
     }
 
     if (input_actions.change_camera_orientation) // only pitch and yaw
@@ -319,79 +270,37 @@ void update()
         float MIN_PITCH = radians(5.0f);
         float MAX_PITCH = radians(175.0f);
 
-        state.camera.yaw += dx * sensitivity_x;
-        state.camera.pitch += (-dy) * sensitivity_y;
-        state.camera.pitch = state.camera.pitch > MAX_PITCH ? MAX_PITCH : state.camera.pitch < MIN_PITCH ? MIN_PITCH : state.camera.pitch;
+        state.scene.camera.yaw += dx * sensitivity_x;
+        state.scene.camera.pitch += (-dy) * sensitivity_y;
+        state.scene.camera.pitch = state.scene.camera.pitch > MAX_PITCH ? MAX_PITCH : state.scene.camera.pitch < MIN_PITCH ? MIN_PITCH : state.scene.camera.pitch;
 
         Vec3f look_towards;
-        look_towards.x = sin(state.camera.pitch) * sin(state.camera.yaw);
-        look_towards.y = cos(state.camera.pitch);
-        look_towards.z = sin(state.camera.pitch) * cos(state.camera.yaw);
+        look_towards.x = sin(state.scene.camera.pitch) * sin(state.scene.camera.yaw);
+        look_towards.y = cos(state.scene.camera.pitch);
+        look_towards.z = sin(state.scene.camera.pitch) * cos(state.scene.camera.yaw);
 
-        state.camera.dir = look_towards;
+        state.scene.camera.dir = look_towards;
     }
 
     float movement_sensitivity = 0.025f;
     if (input_actions.move_camera_forward)
     {
-        Mat3x3f camera_inv = Mat4x4f::look_at(state.camera.pos, state.camera.dir, state.camera.up).truncated().transposed();
-        state.camera.pos = state.camera.pos + (camera_inv * Vec3f(0.0f, 0.0f, -movement_sensitivity));
+        Mat3x3f camera_inv = Mat4x4f::look_at(state.scene.camera.pos, state.scene.camera.dir, state.scene.camera.up).truncated().transposed();
+        state.scene.camera.pos = state.scene.camera.pos + (camera_inv * Vec3f(0.0f, 0.0f, -movement_sensitivity));
     }
     if (input_actions.move_camera_back)
     {
-        Mat3x3f camera_inv = Mat4x4f::look_at(state.camera.pos, state.camera.dir, state.camera.up).truncated().transposed();
-        state.camera.pos = state.camera.pos + (camera_inv * Vec3f(0.0f, 0.0f, movement_sensitivity));
+        Mat3x3f camera_inv = Mat4x4f::look_at(state.scene.camera.pos, state.scene.camera.dir, state.scene.camera.up).truncated().transposed();
+        state.scene.camera.pos = state.scene.camera.pos + (camera_inv * Vec3f(0.0f, 0.0f, movement_sensitivity));
     }
     if (input_actions.move_camera_left)
     {
-        Mat3x3f camera_inv = Mat4x4f::look_at(state.camera.pos, state.camera.dir, state.camera.up).truncated().transposed();
-        state.camera.pos = state.camera.pos + (camera_inv * Vec3f(-movement_sensitivity, 0.0f, 0.0f));
+        Mat3x3f camera_inv = Mat4x4f::look_at(state.scene.camera.pos, state.scene.camera.dir, state.scene.camera.up).truncated().transposed();
+        state.scene.camera.pos = state.scene.camera.pos + (camera_inv * Vec3f(-movement_sensitivity, 0.0f, 0.0f));
     }
     if (input_actions.move_camera_right)
     {
-        Mat3x3f camera_inv = Mat4x4f::look_at(state.camera.pos, state.camera.dir, state.camera.up).truncated().transposed();
-        state.camera.pos = state.camera.pos + (camera_inv * Vec3f(movement_sensitivity, 0.0f, 0.0f));
-    }
-}
-
-Buffer* tga_image_to_buffer(TGAImage& img)
-{
-    Buffer* buffer = new Buffer();
-    init_buffer(img.get_width(), img.get_height(), 3, buffer);
-
-    for (int y = 0; y < img.get_height(); y++)
-    {
-        for (int x = 0; x < img.get_width(); x++)
-        {
-            TGAColor tga_color = img.get(x, y);
-            Vec3f rgb (tga_color.r / 255.0f, tga_color.g / 255.0f, tga_color.b / 255.0f);
-            set_element(x, y, rgb.raw, buffer);
-        }
+        Mat3x3f camera_inv = Mat4x4f::look_at(state.scene.camera.pos, state.scene.camera.dir, state.scene.camera.up).truncated().transposed();
+        state.scene.camera.pos = state.scene.camera.pos + (camera_inv * Vec3f(movement_sensitivity, 0.0f, 0.0f));
     }
-
-    return buffer;
 }
-
-void set_fragment(Fragment& frag, Buffer* color_buffer, Buffer* depth_buffer, Buffer* texture)
-{
-    bool is_out_of_bounds = (frag.pixel.x < 0 || frag.pixel.x >= color_buffer->width) || (frag.pixel.y < 0 || frag.pixel.y >= color_buffer->height);
-    float depth; get_element(frag.pixel.x, frag.pixel.y, &depth, depth_buffer);
-    bool is_hidden = depth > frag.depth;
-
-    if (!is_out_of_bounds && !is_hidden)
-    {
-        sample_bilinear(clampf(frag.uv.x, 0.0f, 1.0f), clampf(frag.uv.y, 0.0f, 1.0f), frag.color.raw, texture);
-
-        float n = state.camera.near;
-        float f = state.camera.far;
-
-        float depth_normalized = (1.0f - ((std::abs(frag.depth) - n) / (7.0f + 2.0f*sin(SDL_GetTicks()*0.001f))));
-        depth_normalized = clampf(depth_normalized, 0.0f, 1.0f);
-        Vec3f gray_scale_depth_color (depth_normalized);
-
-        Vec3f frag_color = frag.color;
-
-        set_element(frag.pixel.x, frag.pixel.y, frag_color.raw, color_buffer);
-        set_element(frag.pixel.x, frag.pixel.y, &frag.depth, depth_buffer);
-    }
-}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "Mesh.h"
+#include "Texture.h"
+#include "Pack.h"
+#include "WorkerPool.h"
+#include "tgaimage.h"
+
+/**
+ * Offline asset baker, writes meshes and textures into one pack file (see Pack.h).
+ *
+ * USAGE: bake.exe output.pack asset...
+ *
+ * .obj files become indexed triangle meshes, .tga files become textures with a full mip chain.
+ * Every asset is stored under the path it was given on the command line, which is
+ * also the path the scene loads it by.
+ */
+
+static bool has_extension(const char* filename, const char* extension)
+{
+    int length = strlen(filename), extension_length = strlen(extension);
+    return length >= extension_length && !strcmp(filename + length - extension_length, extension);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "USAGE: bake.exe output.pack asset...\n";
+        return 1;
+    }
+
+    init_worker_pool(std::thread::hardware_concurrency());
+
+    PackContents contents;
+    bool is_ok = true;
+    for (int i = 2; i < argc && is_ok; i++)
+    {
+        const char* filename = argv[i];
+        if (strlen(filename) >= PACK_NAME_SIZE)
+        {
+            std::cerr << "Error:: asset path too long for a pack " << filename << '\n';
+            is_ok = false;
+        }
+        else if (has_extension(filename, ".obj"))
+        {
+            contents.mesh_names.push_back(filename);
+            contents.meshes.push_back(new Mesh(filename));
+            is_ok = contents.meshes.back()->is_loaded;
+        }
+        else if (has_extension(filename, ".tga"))
+        {
+            TGAImage image;
+            is_ok = image.read_tga_file(filename);
+            if (!is_ok) break;
+
+            contents.texture_names.push_back(filename);
+            contents.textures.push_back(tga_image_to_texture(image));
+        }
+        else
+        {
+            std::cerr << "Error:: don't know how to bake " << filename << '\n';
+            is_ok = false;
+        }
+    }
+
+    is_ok = is_ok && write_pack(argv[1], contents);
+    if (is_ok) std::cout << "baked " << contents.meshes.size() << " meshes, " << contents.textures.size() << " textures into " << argv[1] << '\n';
+
+    destroy_worker_pool();
+    return is_ok ? 0 : 1;
+}
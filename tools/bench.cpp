@@ -0,0 +1,479 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Vec.h"
+#include "Mat.h"
+#include "Geometry.h"
+#include "Rasterize.h"
+#include "Buffer.h"
+#include "Texture.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include "Scale.h"
+#include "Present.h"
+#include "WorkerPool.h"
+#include "Util.h"
+
+/**
+ * Benchmark suite, micro-benchmarks of the pipeline's building blocks and whole scene frames.
+ *
+ * USAGE: bench.exe [--threads T] [--min-ms M] [--out file.csv|file.json] [--filter text]
+ *
+ * Every benchmark runs for at least M milliseconds (200 by default) per round, for 3 rounds,
+ * and reports its best round. One row per benchmark goes to stdout as CSV:
+ *
+ *      name, ops, ns/op, triangles/s, fragments/s
+ *
+ * (the rates are 0 where they do not apply). An op is one call of the named function, except
+ * for the scene rows where it is one frame. Triangles are input triangles for the rasterizer rows
+ * and triangles after clipping for the scene rows, not the pieces either rasterizer splits them
+ * into, so the rates compare across rasterizers. Scene rows render a grid of textured cubes
+ * orbited by the camera through 16 fixed poses, at several resolutions, object counts and
+ * rasterizers. With an out path the rows are also written there, as a JSON array for a .json
+ * path. Only benchmarks whose name contains the filter text are run. Must be run from the
+ * repository root (asset paths are relative).
+ */
+
+const int ROUNDS = 3;
+const int SCENE_POSES = 16;
+const Vec3f CLEAR_COLOR (0.1f, 0.1f, 0.5f);
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t ops;
+    double ns_per_op;
+    double triangles_per_s;
+    double fragments_per_s;
+};
+
+struct BenchRun
+{
+    double min_ms = 200.0;
+    const char* filter = "";
+    std::vector<BenchResult> results;
+};
+
+// Work done per op, for the rates
+struct BenchCounts
+{
+    uint64_t triangles, fragments;
+};
+
+static uint64_t checksum = 0; // printed at the end, keeps the timed loops from being optimized out
+
+static bool is_selected(const BenchRun& run, const std::string& name)
+{
+    return strstr(name.c_str(), run.filter) != nullptr;
+}
+
+/**
+ * Times body, which does ops_per_call ops and returns their counts, until min_ms passed,
+ * keeps the best of the rounds
+ */
+template <class Body>
+static void run_bench(BenchRun& run, const std::string& name, int ops_per_call, Body body)
+{
+    if (!is_selected(run, name)) return;
+
+    body(); // warm up caches, thread locals and lazy allocations
+
+    BenchResult best = { name, 0, 0.0, 0.0, 0.0 };
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        uint64_t calls = 0;
+        BenchCounts counts = { 0, 0 };
+        double elapsed_ns = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        while (elapsed_ns < run.min_ms * 1e6)
+        {
+            BenchCounts call_counts = body();
+            counts.triangles += call_counts.triangles;
+            counts.fragments += call_counts.fragments;
+            calls++;
+            elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        uint64_t ops = calls * ops_per_call;
+        double ns_per_op = elapsed_ns / ops;
+        if (r == 0 || ns_per_op < best.ns_per_op)
+        {
+            best.ops = ops;
+            best.ns_per_op = ns_per_op;
+            best.triangles_per_s = counts.triangles / (elapsed_ns * 1e-9);
+            best.fragments_per_s = counts.fragments / (elapsed_ns * 1e-9);
+        }
+    }
+
+    printf("%s, %llu, %.3f, %.0f, %.0f\n", best.name.c_str(), (unsigned long long) best.ops, best.ns_per_op, best.triangles_per_s, best.fragments_per_s);
+    fflush(stdout);
+    run.results.push_back(best);
+}
+
+// Same sequence on every run, so every run times the same work
+static uint32_t next_random(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+static float random_float(uint32_t& state, float min, float max)
+{
+    return min + (max - min) * (next_random(state) / 16777216.0f);
+}
+
+static std::string get_size_name(int width, int height)
+{
+    return std::to_string(width) + "x" + std::to_string(height);
+}
+
+// Fragment stage that only counts, so the raster rows time the rasterizer alone
+struct CountFragments
+{
+    uint64_t count;
+    uint64_t hash;
+
+    void set_uv_gradients(const Vec2f&, const Vec2f&) {}
+
+    void operator()(int x, int y, float, const Vec2f&)
+    {
+        count++;
+        hash += x ^ y;
+    }
+};
+
+static void bench_math(BenchRun& run)
+{
+    const int MULTIPLIES = 1024;
+    Mat4x4f rotation = Mat4x4f::rotation_y(0.01f) * Mat4x4f::rotation_x(0.02f);
+    Mat4x4f matrix = Mat4x4f::identity_matrix();
+    run_bench(run, "mat4_mul", MULTIPLIES, [&]()
+    {
+        for (int i = 0; i < MULTIPLIES; i++) matrix = matrix * rotation;
+        checksum += matrix.mat[0][0] > 0.0f;
+        return BenchCounts { 0, 0 };
+    });
+
+    // Triangle that straddles the plane, so both sides get a polygon
+    std::vector<Vertex> triangle (3);
+    triangle[0].cull = Vec3f(-1.0f, -1.0f, 0.0f);
+    triangle[1].cull = Vec3f( 1.0f, -1.0f, 0.0f);
+    triangle[2].cull = Vec3f( 0.0f,  1.0f, 0.0f);
+    for (Vertex& v : triangle)
+    {
+        v.device = v.cull.xy();
+        v.view = v.cull;
+        v.world = v.cull;
+    }
+    Plane plane { 0.0f, 1.0f, 0.0f, 0.0f };
+    std::vector<Vertex> in, out;
+    const int CULLS = 256;
+    run_bench(run, "cull_polygon", CULLS, [&]()
+    {
+        for (int i = 0; i < CULLS; i++)
+        {
+            cull_polygon(triangle, plane, in, out);
+            checksum += in.size() + out.size();
+        }
+        return BenchCounts { 0, 0 };
+    });
+}
+
+// Random triangles inside a square, rasterized with a counting fragment stage
+static void bench_raster(BenchRun& run)
+{
+    const int TRIANGLE_COUNT = 512;
+    const int AREA_SIZE = 512;
+    const float SIZES[] = { 4.0f, 32.0f, 128.0f };
+
+    for (float size : SIZES)
+    {
+        uint32_t state = 1;
+        std::vector<Vertex> vertices (TRIANGLE_COUNT * 3);
+        for (int t = 0; t < TRIANGLE_COUNT; t++)
+        {
+            Vec2f center (random_float(state, size, AREA_SIZE - size), random_float(state, size, AREA_SIZE - size));
+            for (int i = 0; i < 3; i++)
+            {
+                // Counter-clockwise, a third of a turn apart plus some jitter
+                float angle = radians(120.0f * i) + random_float(state, -0.5f, 0.5f);
+                Vertex& v = vertices[t * 3 + i];
+                v = Vertex();
+                v.device = Vec2f(center.x + size * std::cos(angle), center.y + size * std::sin(angle));
+                v.depth = -random_float(state, 1.0f, 10.0f);
+                v.cull = Vec3f(v.device.x, v.device.y, 0.0f);
+                v.uv = Vec2f(random_float(state, 0.0f, 1.0f), random_float(state, 0.0f, 1.0f));
+            }
+        }
+
+        Rect bounds { 0, 0, AREA_SIZE, AREA_SIZE };
+        std::string size_name = std::to_string((int) size) + "px";
+        for (int mode = 0; mode < 2; mode++)
+        {
+            std::string name = std::string(mode == RASTER_SCANLINE ? "rasterize_polygon_" : "rasterize_polygon_half_space_") + size_name;
+            run_bench(run, name, TRIANGLE_COUNT, [&]()
+            {
+                CountFragments stage = { 0, 0 };
+                for (int t = 0; t < TRIANGLE_COUNT; t++)
+                {
+                    if (mode == RASTER_SCANLINE) rasterize_polygon(&vertices[t * 3], 3, bounds, stage);
+                    else                         rasterize_polygon_half_space(&vertices[t * 3], 3, bounds, stage);
+                }
+                checksum += stage.hash;
+                return BenchCounts { (uint64_t) TRIANGLE_COUNT, stage.count };
+            });
+        }
+    }
+}
+
+static void bench_sampling(BenchRun& run)
+{
+    const int SAMPLE_COUNT = 4096;
+    const int TEXTURE_SIZE = 256;
+
+    uint32_t state = 1;
+    std::vector<float> us (SAMPLE_COUNT), vs (SAMPLE_COUNT);
+    for (int i = 0; i < SAMPLE_COUNT; i++)
+    {
+        us[i] = random_float(state, 0.0f, 1.0f);
+        vs[i] = random_float(state, 0.0f, 1.0f);
+    }
+
+    Texture texture;
+    init_texture(TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_RGBA8, TEXTURE_TILED, 1, &texture);
+    for (size_t i = 0; i < texture.storage.size(); i++) texture.storage[i] = (i * 2654435761u) >> 24;
+    run_bench(run, "sample_bilinear_texture", SAMPLE_COUNT, [&]()
+    {
+        Float4 sum = float4(0.0f);
+        for (int i = 0; i < SAMPLE_COUNT; i++) sum = sum + sample_bilinear(us[i], vs[i], 0, &texture);
+        float lanes[4];
+        store_float4(lanes, sum);
+        checksum += lanes[0] > 0.0f;
+        return BenchCounts { 0, 0 };
+    });
+
+    Buffer buffer = {};
+    init_buffer(TEXTURE_SIZE, TEXTURE_SIZE, 3, &buffer);
+    for (int i = 0; i < TEXTURE_SIZE * TEXTURE_SIZE * 3; i++) buffer.data[i] = (i % 251) / 251.0f;
+    run_bench(run, "sample_bilinear_buffer", SAMPLE_COUNT, [&]()
+    {
+        float sum = 0.0f, sample[3];
+        for (int i = 0; i < SAMPLE_COUNT; i++)
+        {
+            sample_bilinear(us[i], vs[i], sample, &buffer);
+            sum += sample[0];
+        }
+        checksum += sum > 0.0f;
+        return BenchCounts { 0, 0 };
+    });
+    delete[] buffer.data;
+}
+
+// Whole buffer operations at a typical window size
+static void bench_buffers(BenchRun& run)
+{
+    const int WIDTH = 1920, HEIGHT = 1080;
+    std::string size_name = get_size_name(WIDTH, HEIGHT);
+
+    Buffer screen = {}, half = {};
+    init_buffer(WIDTH, HEIGHT, 3, &screen);
+    init_buffer(WIDTH / 2, HEIGHT / 2, 3, &half);
+    const float clear[3] = { 0.1f, 0.1f, 0.5f };
+    clear_buffer(clear, &half);
+
+    run_bench(run, "clear_buffer_" + size_name, 1, [&]()
+    {
+        clear_buffer(clear, &screen);
+        return BenchCounts { 0, 0 };
+    });
+
+    run_bench(run, "blit_buffer_" + size_name, 1, [&]()
+    {
+        blit_buffer(&half, &screen, 0.0f, 0.0f, 1.0f, 1.0f);
+        return BenchCounts { 0, 0 };
+    });
+
+    run_bench(run, "scale_buffer_" + size_name, 1, [&]()
+    {
+        scale_buffer(&half, &screen, 0, 0, WIDTH, HEIGHT);
+        return BenchCounts { 0, 0 };
+    });
+
+    // blit_window's conversion, into plain memory laid out like a window surface
+    std::vector<uint8_t> pixels (WIDTH * HEIGHT * 4);
+    PresentTarget target = { pixels.data(), WIDTH, HEIGHT, WIDTH * 4, PIXEL_BGRA };
+    for (int is_srgb = 0; is_srgb < 2; is_srgb++)
+    {
+        run_bench(run, std::string(is_srgb ? "present_pixels_srgb_" : "present_pixels_") + size_name, 1, [&]()
+        {
+            present_pixels(screen.data, is_srgb, target);
+            checksum += pixels[0];
+            return BenchCounts { 0, 0 };
+        });
+    }
+
+    FrameBuffer frame_buffer;
+    init_frame_buffer(WIDTH, HEIGHT, COLOR_RGBA8, DEPTH_32F, &frame_buffer);
+    clear_frame_buffer(CLEAR_COLOR, &frame_buffer);
+    run_bench(run, "resolve_frame_buffer_" + size_name, 1, [&]()
+    {
+        resolve_frame_buffer(&frame_buffer, &screen);
+        return BenchCounts { 0, 0 };
+    });
+
+    delete[] screen.data;
+    delete[] half.data;
+}
+
+// Cubes on a grid around the origin, filled in row by row up to the object count
+static void set_cube_grid(int object_count, const Object& cube, Scene& scene, float& orbit_radius)
+{
+    const float SPACING = 1.5f;
+    int side = std::ceil(std::cbrt((float) object_count) - 0.001f);
+    float center = (side - 1) * SPACING * 0.5f;
+
+    scene.objects.clear();
+    for (int i = 0; i < object_count; i++)
+    {
+        Object object = cube;
+        object.translation = Vec3f((i % side) * SPACING - center, ((i / side) % side) * SPACING - center, (i / (side * side)) * SPACING - center);
+        scene.objects.push_back(object);
+    }
+
+    orbit_radius = 4.0f + side * SPACING;
+    scene.camera.far = 2.0f * orbit_radius + side * SPACING;
+}
+
+static void bench_scenes(BenchRun& run)
+{
+    const int SIZES[][2] = { { 320, 240 }, { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+    const int OBJECT_COUNTS[] = { 8, 64, 512 };
+
+    Scene scene;
+    scene.camera.up = Vec3f(0.0f, 1.0f, 0.0f);
+    scene.camera.near = 1.0f;
+    init_rubik_scene(scene);
+    Object cube = scene.objects[0];
+
+    FrameBuffer frame_buffer;
+    init_frame_buffer(SIZES[0][0], SIZES[0][1], COLOR_RGBA8, DEPTH_32F, &frame_buffer);
+
+    for (const int* size : SIZES)
+    {
+        resize_frame_buffer(size[0], size[1], &frame_buffer);
+        scene.camera.aspect_ratio = ((float) size[0]) / ((float) size[1]);
+
+        for (int object_count : OBJECT_COUNTS)
+        {
+            float orbit_radius;
+            set_cube_grid(object_count, cube, scene, orbit_radius);
+
+            for (int mode = 0; mode < 2; mode++)
+            {
+                std::string name = "scene_" + get_size_name(size[0], size[1]) + "_objects" + std::to_string(object_count) + (mode == RASTER_SCANLINE ? "_scanline" : "_half_space");
+                render_settings.raster_mode = (RasterMode) mode;
+                run_bench(run, name, SCENE_POSES, [&]()
+                {
+                    BenchCounts counts = { 0, 0 };
+                    for (int pose = 0; pose < SCENE_POSES; pose++)
+                    {
+                        set_orbit_camera(radians(180.0f) + radians(360.0f) * ((float) pose / (float) SCENE_POSES), radians(100.0f), orbit_radius, &scene.camera);
+                        clear_frame_buffer(CLEAR_COLOR, &frame_buffer);
+                        render_scene(scene, &frame_buffer);
+
+                        PipelineStats stats = get_pipeline_stats();
+                        counts.triangles += stats.triangles_binned;
+                        counts.fragments += stats.fragments_generated;
+                    }
+                    return counts;
+                });
+            }
+        }
+    }
+    render_settings.raster_mode = RASTER_SCANLINE;
+}
+
+static bool write_results(const char* path, const std::vector<BenchResult>& results)
+{
+    const char* extension = strrchr(path, '.');
+    bool is_json = extension && !strcmp(extension, ".json");
+    FILE* file = fopen(path, "w");
+    if (!file)
+    {
+        std::cerr << "Error:: could not open " << path << '\n';
+        return false;
+    }
+
+    if (!is_json) fprintf(file, "name,ops,ns_per_op,triangles_per_s,fragments_per_s\n");
+    else          fprintf(file, "[");
+    for (int i = 0; i < results.size(); i++)
+    {
+        const BenchResult& result = results[i];
+        if (is_json)
+        {
+            fprintf(file, "%s\n{\"name\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.3f,\"triangles_per_s\":%.0f,\"fragments_per_s\":%.0f}", i ? "," : "",
+                    result.name.c_str(), (unsigned long long) result.ops, result.ns_per_op, result.triangles_per_s, result.fragments_per_s);
+        }
+        else
+        {
+            fprintf(file, "%s,%llu,%.3f,%.0f,%.0f\n", result.name.c_str(), (unsigned long long) result.ops, result.ns_per_op, result.triangles_per_s, result.fragments_per_s);
+        }
+    }
+    if (is_json) fprintf(file, "\n]\n");
+
+    bool is_written = !ferror(file);
+    fclose(file);
+    if (!is_written) std::cerr << "Error:: could not write " << path << '\n';
+    return is_written;
+}
+
+int main(int argc, char** argv)
+{
+    BenchRun run;
+    int thread_count = std::thread::hardware_concurrency();
+    const char* output_path = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (!strcmp(argv[i], "--threads")) thread_count = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--min-ms"))  run.min_ms = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--out"))     output_path = argv[i + 1];
+        else if (!strcmp(argv[i], "--filter"))  run.filter = argv[i + 1];
+        else
+        {
+            std::cerr << "Error:: unknown option " << argv[i] << '\n';
+            return 1;
+        }
+    }
+    if (argc % 2 == 0)
+    {
+        std::cerr << "Error:: missing value for " << argv[argc - 1] << '\n';
+        return 1;
+    }
+    if (thread_count < 1 || run.min_ms <= 0.0)
+    {
+        std::cerr << "Error:: threads and min-ms must be positive\n";
+        return 1;
+    }
+
+    init_worker_pool(thread_count);
+    std::cout << "threads " << thread_count << ", " << run.min_ms << " ms per round, best of " << ROUNDS << "\n";
+    std::cout << "name, ops, ns/op, triangles/s, fragments/s\n";
+
+    bench_math(run);
+    bench_raster(run);
+    bench_sampling(run);
+    bench_buffers(run);
+    bench_scenes(run);
+
+    std::cout << "checksum " << checksum << '\n';
+    bool is_written = !output_path || write_results(output_path, run.results);
+    destroy_worker_pool();
+    return is_written ? 0 : 1;
+}
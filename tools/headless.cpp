@@ -0,0 +1,265 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "Vec.h"
+#include "Mat.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include "DynamicResolution.h"
+#include "Scale.h"
+#include "Profiler.h"
+#include "WorkerPool.h"
+#include "Util.h"
+
+/**
+ * Headless offscreen renderer, does not link against SDL.
+ *
+ * USAGE: headless_build.exe [--frames N] [--width W] [--height H] [--out file.tga]
+ *                           [--threads T] [--raster scanline|half_space]
+ *                           [--filter nearest|bilinear|trilinear]
+ *                           [--color rgba8|rgb10a2] [--depth 16|24|32f]
+ *                           [--budget ms] [--profile trace.json] [--stats file.csv|file.json]
+ *                           [--scene rubik|stress] [--objects N] [--object-triangles N]
+ *                           [--min-size S] [--max-size S] [--depth-complexity D]
+ *                           [--textures N] [--seed S]
+ *
+ * Renders the rubik scene for a fixed number of frames while the camera
+ * orbits the origin, prints render throughput, then writes the last frame
+ * out as a TGA image. With a budget the render scale is picked by the dynamic resolution
+ * controller, and the last frame is scaled back up to the full resolution to be written.
+ * With a profile path it also prints per-stage times and writes a Chrome trace there,
+ * with a stats path it writes every frame's pipeline statistics there. The stress scene
+ * (see StressSceneSettings for what the numbers mean) is rendered from its own fixed camera
+ * instead of the orbit. Must be run from the repository root (asset paths are relative).
+ */
+
+const Vec3f CLEAR_COLOR (0.1f, 0.1f, 0.5f);
+const float ORBIT_RADIUS = 5.0f;
+const float MIN_DYNAMIC_SCALE = 0.25f;
+
+struct Options
+{
+    int frame_count = 100;
+    int width = 640, height = 480;
+    const char* output_path = "headless.tga";
+    int thread_count = std::thread::hardware_concurrency();
+    RasterMode raster_mode = RASTER_SCANLINE;
+    TextureFilter texture_filter = FILTER_TRILINEAR;
+    ColorFormat color_format = COLOR_RGBA8;
+    DepthFormat depth_format = DEPTH_32F;
+    float budget_ms = 0.0f; // 0 renders at a fixed full resolution
+    const char* profile_path = nullptr;
+    const char* stats_path = nullptr;
+    bool is_stress_scene = false;
+    StressSceneSettings stress;
+};
+
+bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* name = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Error: missing value for " << name << "\n";
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if      (!strcmp(name, "--frames"))  options.frame_count  = atoi(value);
+        else if (!strcmp(name, "--width"))   options.width        = atoi(value);
+        else if (!strcmp(name, "--height"))  options.height       = atoi(value);
+        else if (!strcmp(name, "--out"))     options.output_path  = value;
+        else if (!strcmp(name, "--threads")) options.thread_count = atoi(value);
+        else if (!strcmp(name, "--budget"))  options.budget_ms    = atof(value);
+        else if (!strcmp(name, "--profile")) options.profile_path = value;
+        else if (!strcmp(name, "--stats"))   options.stats_path   = value;
+        else if (!strcmp(name, "--objects"))          options.stress.object_count         = atoi(value);
+        else if (!strcmp(name, "--object-triangles")) options.stress.triangles_per_object = atoi(value);
+        else if (!strcmp(name, "--min-size"))         options.stress.min_triangle_size    = atof(value);
+        else if (!strcmp(name, "--max-size"))         options.stress.max_triangle_size    = atof(value);
+        else if (!strcmp(name, "--depth-complexity")) options.stress.depth_complexity     = atof(value);
+        else if (!strcmp(name, "--textures"))         options.stress.texture_count        = atoi(value);
+        else if (!strcmp(name, "--seed"))             options.stress.seed                 = strtoul(value, nullptr, 10);
+        else if (!strcmp(name, "--scene"))
+        {
+            if      (!strcmp(value, "rubik"))  options.is_stress_scene = false;
+            else if (!strcmp(value, "stress")) options.is_stress_scene = true;
+            else
+            {
+                std::cerr << "Error: unknown scene " << value << "\n";
+                return false;
+            }
+        }
+        else if (!strcmp(name, "--raster"))
+        {
+            if      (!strcmp(value, "scanline"))   options.raster_mode = RASTER_SCANLINE;
+            else if (!strcmp(value, "half_space")) options.raster_mode = RASTER_HALF_SPACE;
+            else
+            {
+                std::cerr << "Error: unknown raster mode " << value << "\n";
+                return false;
+            }
+        }
+        else if (!strcmp(name, "--filter"))
+        {
+            if      (!strcmp(value, "nearest"))   options.texture_filter = FILTER_NEAREST;
+            else if (!strcmp(value, "bilinear"))  options.texture_filter = FILTER_BILINEAR;
+            else if (!strcmp(value, "trilinear")) options.texture_filter = FILTER_TRILINEAR;
+            else
+            {
+                std::cerr << "Error: unknown texture filter " << value << "\n";
+                return false;
+            }
+        }
+        else if (!strcmp(name, "--color"))
+        {
+            if      (!strcmp(value, "rgba8"))   options.color_format = COLOR_RGBA8;
+            else if (!strcmp(value, "rgb10a2")) options.color_format = COLOR_RGB10A2;
+            else
+            {
+                std::cerr << "Error: unknown color format " << value << "\n";
+                return false;
+            }
+        }
+        else if (!strcmp(name, "--depth"))
+        {
+            if      (!strcmp(value, "16"))  options.depth_format = DEPTH_16;
+            else if (!strcmp(value, "24"))  options.depth_format = DEPTH_24;
+            else if (!strcmp(value, "32f")) options.depth_format = DEPTH_32F;
+            else
+            {
+                std::cerr << "Error: unknown depth format " << value << "\n";
+                return false;
+            }
+        }
+        else
+        {
+            std::cerr << "Error: unknown option " << name << "\n";
+            return false;
+        }
+    }
+
+    if (options.frame_count < 1 || options.width < 1 || options.height < 1 || options.thread_count < 1)
+    {
+        std::cerr << "Error: frames, width, height and threads must be positive\n";
+        return false;
+    }
+
+    const StressSceneSettings& stress = options.stress;
+    if (stress.object_count < 1 || stress.triangles_per_object < 1 || stress.texture_count < 1 || stress.min_triangle_size <= 0.0f
+        || stress.max_triangle_size < stress.min_triangle_size || stress.depth_complexity <= 0.0f)
+    {
+        std::cerr << "Error: objects, object triangles, textures, sizes and depth complexity must be positive, max size at least min size\n";
+        return false;
+    }
+
+    return true;
+}
+
+// Fixed camera path, one full orbit around the y-axis over the frame count
+void set_camera_on_path(Camera& camera, int frame, int frame_count)
+{
+    set_orbit_camera(radians(180.0f) + radians(360.0f) * ((float) frame / (float) frame_count), radians(100.0f), ORBIT_RADIUS, &camera);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+
+    init_worker_pool(options.thread_count);
+    init_profiler(options.thread_count);
+    set_profiling(options.profile_path != nullptr);
+    render_settings.raster_mode = options.raster_mode;
+    render_settings.texture_filter = options.texture_filter;
+
+    FrameBuffer frame_buffer;
+    init_frame_buffer(options.width, options.height, options.color_format, options.depth_format, &frame_buffer);
+
+    ResolutionController resolution;
+    init_resolution_controller(options.budget_ms, MIN_DYNAMIC_SCALE, 1.0f, &resolution);
+    int resolution_changes = 0;
+
+    StatsWriter stats_writer = {};
+    if (options.stats_path && !open_stats_writer(options.stats_path, &stats_writer)) return 1;
+
+    Scene scene;
+    scene.camera.up = Vec3f(0.0f, 1.0f, 0.0f);
+    scene.camera.aspect_ratio = ((float) options.width) / ((float) options.height);
+    scene.camera.near = 1.0f;
+    scene.camera.far = 25.0f;
+    if (options.is_stress_scene) init_stress_scene(options.stress, scene);
+    else                         init_rubik_scene(scene);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frame_count; frame++)
+    {
+        ProfileScope frame_scope (STAGE_FRAME, 0);
+        if (!options.is_stress_scene)
+        {
+            set_camera_on_path(scene.camera, frame, options.frame_count);
+            scene.world = Mat4x4f::rotation_y(0.015f * frame) * Mat4x4f::rotation_x(radians(7.0f) * sin(frame * 0.05f));
+        }
+
+        clear_frame_buffer(CLEAR_COLOR, &frame_buffer);
+        auto render_start = std::chrono::steady_clock::now();
+        render_scene(scene, &frame_buffer);
+        if (options.stats_path) write_stats_frame(get_pipeline_stats(), &stats_writer);
+        float render_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - render_start).count();
+
+        // Not on the last frame, it is the one written out
+        if (options.budget_ms > 0.0f && frame + 1 < options.frame_count && update_resolution_controller(render_ms, &resolution))
+        {
+            resize_frame_buffer(max_i(1, options.width * resolution.scale), max_i(1, options.height * resolution.scale), &frame_buffer);
+            resolution_changes++;
+        }
+
+        frame_scope.end();
+        end_profiler_frame();
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    float total_ms = std::chrono::duration_cast<std::chrono::duration<float, std::milli>>(stop - start).count();
+    std::cout << "frames: " << options.frame_count << "\n";
+    std::cout << "resolution: " << options.width << "x" << options.height << "\n";
+    std::cout << "threads: " << options.thread_count << "\n";
+    std::cout << "total ms: " << total_ms << "\n";
+    std::cout << "ms/frame: " << total_ms / options.frame_count << "\n";
+    std::cout << "frames/s: " << options.frame_count / (total_ms / 1000.0f) << "\n";
+
+    PipelineStats stats = get_pipeline_stats();
+    std::cout << "last frame: " << stats.faces_submitted << " faces, " << stats.triangles_rasterized << " triangles rasterized, "
+              << stats.fragments_generated << " fragments, overdraw " << get_frame_overdraw(stats) << "\n";
+    close_stats_writer(&stats_writer);
+    if (options.budget_ms > 0.0f)
+    {
+        std::cout << "final scale: " << resolution.scale << " (" << frame_buffer.width << "x" << frame_buffer.height << ")\n";
+        std::cout << "scale changes: " << resolution_changes << "\n";
+    }
+
+    Buffer color = {}, scaled = {};
+    init_buffer(frame_buffer.width, frame_buffer.height, 3, &color);
+    init_buffer(options.width, options.height, 3, &scaled);
+    resolve_frame_buffer(&frame_buffer, &color);
+    scale_buffer(&color, &scaled, 0, 0, options.width, options.height);
+    TGAImage image = buffer_to_tga_image(&scaled);
+
+    if (options.profile_path)
+    {
+        print_profile();
+        if (!write_chrome_trace(options.profile_path)) return 1;
+    }
+
+    if (!image.write_tga_file(options.output_path))
+    {
+        std::cerr << "Error: could not write " << options.output_path << "\n";
+        return 1;
+    }
+
+    destroy_worker_pool();
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "Mesh.h"
+#include "MeshOptimize.h"
+#include "WorkerPool.h"
+
+/**
+ * Triangle order report, what optimize_triangle_order does to each mesh.
+ *
+ * USAGE: mesh_report.exe model.obj...
+ *
+ * Prints ACMR (vertices transformed per triangle, FIFO cache of VERTEX_CACHE_SIZE) and
+ * overdraw (fragments passing an early depth test per covered pixel, averaged over
+ * views around the mesh) for the file's own order and for the optimized one.
+ */
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "USAGE: mesh_report.exe model.obj...\n";
+        return 1;
+    }
+
+    init_worker_pool(std::thread::hardware_concurrency());
+
+    std::cout << "mesh, vertices, triangles, acmr before, acmr after, overdraw before, overdraw after, reorder ms\n";
+    for (int i = 1; i < argc; i++)
+    {
+        Mesh mesh (argv[i], false);
+        if (!mesh.is_loaded) continue; // already reported
+        std::vector<uint32_t> indices (mesh.indices, mesh.indices + mesh.triangle_count * 3);
+
+        float acmr_before = get_acmr(indices.data(), mesh.triangle_count, mesh.vertex_count);
+        float overdraw_before = get_overdraw(indices.data(), mesh.triangle_count, mesh.vertices, mesh.vertex_count);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        optimize_triangle_order(indices.data(), mesh.triangle_count, mesh.vertices, mesh.vertex_count);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        float acmr_after = get_acmr(indices.data(), mesh.triangle_count, mesh.vertex_count);
+        float overdraw_after = get_overdraw(indices.data(), mesh.triangle_count, mesh.vertices, mesh.vertex_count);
+
+        std::cout << argv[i] << ", " << mesh.vertex_count << ", " << mesh.triangle_count << ", "
+                  << acmr_before << ", " << acmr_after << ", " << overdraw_before << ", " << overdraw_after << ", "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << '\n';
+    }
+
+    destroy_worker_pool();
+    return 0;
+}
@@ -0,0 +1,373 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Vec.h"
+#include "Mat.h"
+#include "Scene.h"
+#include "Renderer.h"
+#include "WorkerPool.h"
+#include "Util.h"
+
+/**
+ * Golden image and performance regression harness, does not link against SDL.
+ *
+ * USAGE: regress.exe [--update images|timings|all] [--threads T] [--tolerance N]
+ *                    [--max-bad-pixels fraction] [--threshold fraction] [--frames N]
+ *                    [--references dir] [--baseline file.csv] [--filter text] [--require-timings]
+ *
+ * Renders a fixed set of cases (scene, camera pose and render settings) and compares every
+ * image with its reference TGA: a pixel is bad when a channel is off by more than the tolerance
+ * (2 of 255 by default), a case fails when more than the max bad pixel fraction (0.001) are
+ * bad, or when it has no reference. Bad images are written next to the baseline as <case>.tga
+ * with <case>_diff.tga, which shows the differences 16 times brighter. Each case is then
+ * rendered the number of frames (10) and its fastest frame is compared with the baseline, a
+ * case fails when it got slower by more than the threshold (0.1, so 10%) and stayed that slow
+ * when timed again. Baseline times are kept per thread count, a case without one has its
+ * timing skipped and counted in a note after the table, or fails with --require-timings (for CI,
+ * where a missing baseline should not pass unnoticed).
+ *
+ * References are committed (golden/), the baseline is per machine and lives in bin/ by default.
+ * --update writes them from the current build instead of comparing. Exits with 1 when any
+ * case fails or no case matched the filter. Must be run from the repository root (asset
+ * paths are relative).
+ */
+
+const Vec3f CLEAR_COLOR (0.1f, 0.1f, 0.5f);
+const int WIDTH = 640, HEIGHT = 480;
+const int DIFF_SCALE = 16;
+const int TIMING_RETRIES = 2; // a case that timed slower is timed again, so one stall does not fail it
+
+enum SceneKind { SCENE_RUBIK, SCENE_STRESS };
+
+struct RegressionCase
+{
+    const char* name;
+    SceneKind scene;
+    float yaw, pitch, radius;   // degrees, rubik orbit camera (the stress scene has its own)
+    RasterMode raster_mode;
+    TextureFilter texture_filter;
+    ColorFormat color_format;
+    DepthFormat depth_format;
+    StressSceneSettings stress;
+};
+
+static StressSceneSettings get_stress_settings(int object_count, int triangles_per_object, float min_size, float max_size, float depth_complexity, int texture_count, uint32_t seed)
+{
+    StressSceneSettings settings;
+    settings.object_count = object_count;
+    settings.triangles_per_object = triangles_per_object;
+    settings.min_triangle_size = min_size;
+    settings.max_triangle_size = max_size;
+    settings.depth_complexity = depth_complexity;
+    settings.texture_count = texture_count;
+    settings.seed = seed;
+    return settings;
+}
+
+// NOTE: renaming or changing a case needs its reference written again (--update images)
+static std::vector<RegressionCase> get_cases()
+{
+    StressSceneSettings rubik = {};
+    return
+    {
+        { "rubik_front_scanline",         SCENE_RUBIK,  180.0f, 100.0f, 5.0f, RASTER_SCANLINE,   FILTER_TRILINEAR, COLOR_RGBA8,   DEPTH_32F, rubik },
+        { "rubik_front_half_space",       SCENE_RUBIK,  180.0f, 100.0f, 5.0f, RASTER_HALF_SPACE, FILTER_TRILINEAR, COLOR_RGBA8,   DEPTH_32F, rubik },
+        { "rubik_above_bilinear",         SCENE_RUBIK,  240.0f, 140.0f, 4.0f, RASTER_SCANLINE,   FILTER_BILINEAR,  COLOR_RGBA8,   DEPTH_32F, rubik },
+        { "rubik_below_nearest_packed",   SCENE_RUBIK,  315.0f,  60.0f, 4.0f, RASTER_HALF_SPACE, FILTER_NEAREST,   COLOR_RGB10A2, DEPTH_16,  rubik },
+        { "rubik_near_clip_depth24",      SCENE_RUBIK,  200.0f,  95.0f, 1.8f, RASTER_SCANLINE,   FILTER_TRILINEAR, COLOR_RGBA8,   DEPTH_24,  rubik },
+        { "stress_default",               SCENE_STRESS,   0.0f,   0.0f, 0.0f, RASTER_SCANLINE,   FILTER_TRILINEAR, COLOR_RGBA8,   DEPTH_32F, get_stress_settings(64, 128, 0.01f, 0.05f, 2.0f, 4, 1) },
+        { "stress_overdraw_half_space",   SCENE_STRESS,   0.0f,   0.0f, 0.0f, RASTER_HALF_SPACE, FILTER_TRILINEAR, COLOR_RGBA8,   DEPTH_24,  get_stress_settings(128, 64, 0.01f, 0.03f, 8.0f, 8, 2) },
+        { "stress_small_triangles",       SCENE_STRESS,   0.0f,   0.0f, 0.0f, RASTER_SCANLINE,   FILTER_BILINEAR,  COLOR_RGBA8,   DEPTH_32F, get_stress_settings(32, 2048, 0.002f, 0.006f, 1.5f, 2, 3) },
+    };
+}
+
+struct Options
+{
+    bool is_updating_images = false;
+    bool is_updating_timings = false;
+    int thread_count = std::thread::hardware_concurrency();
+    int tolerance = 2;
+    float max_bad_pixels = 0.001f;
+    float threshold = 0.1f;
+    int frame_count = 10;
+    std::string references = "golden";
+    std::string baseline = "bin/regress_baseline.csv";
+    const char* filter = "";
+    bool is_requiring_timings = false; // a case without a baseline time fails instead of skipping it
+};
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* name = argv[i];
+        if (!strcmp(name, "--require-timings"))
+        {
+            options.is_requiring_timings = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Error: missing value for " << name << "\n";
+            return false;
+        }
+        const char* value = argv[++i];
+
+        if      (!strcmp(name, "--threads"))        options.thread_count   = atoi(value);
+        else if (!strcmp(name, "--tolerance"))      options.tolerance      = atoi(value);
+        else if (!strcmp(name, "--max-bad-pixels")) options.max_bad_pixels = atof(value);
+        else if (!strcmp(name, "--threshold"))      options.threshold      = atof(value);
+        else if (!strcmp(name, "--frames"))         options.frame_count    = atoi(value);
+        else if (!strcmp(name, "--references"))     options.references     = value;
+        else if (!strcmp(name, "--baseline"))       options.baseline       = value;
+        else if (!strcmp(name, "--filter"))         options.filter         = value;
+        else if (!strcmp(name, "--update"))
+        {
+            if      (!strcmp(value, "images"))  options.is_updating_images = true;
+            else if (!strcmp(value, "timings")) options.is_updating_timings = true;
+            else if (!strcmp(value, "all"))     options.is_updating_images = options.is_updating_timings = true;
+            else
+            {
+                std::cerr << "Error: unknown update " << value << "\n";
+                return false;
+            }
+        }
+        else
+        {
+            std::cerr << "Error: unknown option " << name << "\n";
+            return false;
+        }
+    }
+
+    if (options.thread_count < 1 || options.frame_count < 1 || options.tolerance < 0 || options.max_bad_pixels < 0.0f || options.threshold < 0.0f)
+    {
+        std::cerr << "Error: threads and frames must be positive, tolerance, max bad pixels and threshold not negative\n";
+        return false;
+    }
+
+    return true;
+}
+
+// "case,threads" to fastest ms per frame, timings are only compared at the same thread count
+static std::map<std::string, float> read_baseline(const std::string& path)
+{
+    std::map<std::string, float> baseline;
+    std::ifstream file (path);
+    std::string line;
+    std::getline(file, line); // header
+    while (std::getline(file, line))
+    {
+        size_t comma = line.find_last_of(',');
+        if (comma != std::string::npos) baseline[line.substr(0, comma)] = atof(line.c_str() + comma + 1);
+    }
+    return baseline;
+}
+
+static bool write_baseline(const std::string& path, const std::map<std::string, float>& baseline)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+    {
+        std::cerr << "Error: could not open " << path << "\n";
+        return false;
+    }
+
+    fprintf(file, "case,threads,ms_per_frame\n");
+    for (const auto& entry : baseline) fprintf(file, "%s,%.4f\n", entry.first.c_str(), entry.second);
+
+    bool is_written = !ferror(file);
+    fclose(file);
+    if (!is_written) std::cerr << "Error: could not write " << path << "\n";
+    return is_written;
+}
+
+static void init_case_scene(const RegressionCase& test, Scene& scene)
+{
+    scene.camera.up = Vec3f(0.0f, 1.0f, 0.0f);
+    scene.camera.aspect_ratio = ((float) WIDTH) / ((float) HEIGHT);
+    scene.camera.near = 1.0f;
+    scene.camera.far = 25.0f;
+
+    if (test.scene == SCENE_STRESS)
+    {
+        init_stress_scene(test.stress, scene);
+        return;
+    }
+
+    init_rubik_scene(scene);
+    set_orbit_camera(radians(test.yaw), radians(test.pitch), test.radius, &scene.camera);
+}
+
+// Fastest of frame_count frames
+static float time_frames(Scene& scene, int frame_count, FrameBuffer* frame_buffer)
+{
+    float best_ms = 0.0f;
+    for (int frame = 0; frame < frame_count; frame++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        clear_frame_buffer(CLEAR_COLOR, frame_buffer);
+        render_scene(scene, frame_buffer);
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        best_ms = frame == 0 ? ms : minf(best_ms, ms);
+    }
+    return best_ms;
+}
+
+// Pixels with a channel off by more than tolerance, and a diff image of them
+static int compare_images(TGAImage& image, TGAImage& reference, int tolerance, int& max_difference, TGAImage& diff)
+{
+    int bad_pixels = 0;
+    max_difference = 0;
+    for (int y = 0; y < image.get_height(); y++)
+    {
+        for (int x = 0; x < image.get_width(); x++)
+        {
+            TGAColor a = image.get(x, y), b = reference.get(x, y);
+            TGAColor difference (0, 0, 0, 255);
+            int pixel_difference = 0;
+            for (int c = 0; c < 3; c++)
+            {
+                int channel_difference = abs(a.raw[c] - b.raw[c]);
+                pixel_difference = max_i(pixel_difference, channel_difference);
+                difference.raw[c] = min_i(255, channel_difference * DIFF_SCALE);
+            }
+
+            max_difference = max_i(max_difference, pixel_difference);
+            bad_pixels += pixel_difference > tolerance;
+            diff.set(x, y, difference);
+        }
+    }
+    return bad_pixels;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+
+    init_worker_pool(options.thread_count);
+
+    FrameBuffer frame_buffer;
+    Buffer color = {};
+    init_buffer(WIDTH, HEIGHT, 3, &color);
+
+    std::map<std::string, float> baseline = read_baseline(options.baseline);
+    std::string output_directory = options.baseline.substr(0, options.baseline.find_last_of('/') + 1); // bad images go next to the baseline
+
+    printf("case, bad pixels, max difference, image, ms/frame, baseline ms/frame, change, timing\n");
+    int failure_count = 0, case_count = 0, skipped_timing_count = 0;
+    for (const RegressionCase& test : get_cases())
+    {
+        if (!strstr(test.name, options.filter)) continue;
+        case_count++;
+
+        Scene scene;
+        init_case_scene(test, scene);
+        render_settings.raster_mode = test.raster_mode;
+        render_settings.texture_filter = test.texture_filter;
+        init_frame_buffer(WIDTH, HEIGHT, test.color_format, test.depth_format, &frame_buffer);
+
+        // First frame is the image, the rest are timed
+        clear_frame_buffer(CLEAR_COLOR, &frame_buffer);
+        render_scene(scene, &frame_buffer);
+        resolve_frame_buffer(&frame_buffer, &color);
+        TGAImage image = buffer_to_tga_image(&color);
+
+        float best_ms = time_frames(scene, options.frame_count, &frame_buffer);
+
+        std::string reference_path = options.references + "/" + test.name + ".tga";
+        std::string image_result = "skipped";
+        int bad_pixels = 0, max_difference = 0;
+        bool is_failed = false;
+        if (options.is_updating_images)
+        {
+            if (!image.write_tga_file(reference_path.c_str()))
+            {
+                std::cerr << "Error: could not write " << reference_path << "\n";
+                return 1;
+            }
+            image_result = "updated";
+        }
+        else
+        {
+            TGAImage reference;
+            if (!std::ifstream(reference_path).good())
+            {
+                std::cerr << "Error: no reference " << reference_path << " (--update images writes it)\n";
+                image_result = "FAIL";
+                is_failed = true;
+            }
+            else if (!reference.read_tga_file(reference_path.c_str()) || reference.get_width() != WIDTH || reference.get_height() != HEIGHT)
+            {
+                std::cerr << "Error: reference " << reference_path << " is unreadable or not " << WIDTH << "x" << HEIGHT << "\n";
+                image_result = "FAIL";
+                is_failed = true;
+            }
+            else
+            {
+                TGAImage diff (WIDTH, HEIGHT, TGAImage::RGB);
+                bad_pixels = compare_images(image, reference, options.tolerance, max_difference, diff);
+                is_failed = bad_pixels > options.max_bad_pixels * WIDTH * HEIGHT;
+                image_result = is_failed ? "FAIL" : "pass";
+                if (is_failed)
+                {
+                    std::string image_path = output_directory + test.name + ".tga", diff_path = output_directory + test.name + "_diff.tga";
+                    if (!image.write_tga_file(image_path.c_str()) || !diff.write_tga_file(diff_path.c_str())) std::cerr << "Error: could not write " << image_path << " and " << diff_path << "\n";
+                }
+            }
+        }
+
+        std::string timing_result = "skipped";
+        std::string baseline_key = std::string(test.name) + "," + std::to_string(options.thread_count);
+        float baseline_ms = 0.0f, change = 0.0f;
+        if (options.is_updating_timings)
+        {
+            baseline[baseline_key] = best_ms;
+            timing_result = "updated";
+        }
+        else if (baseline.count(baseline_key))
+        {
+            baseline_ms = baseline[baseline_key];
+            for (int retry = 0; retry < TIMING_RETRIES && best_ms > baseline_ms * (1.0f + options.threshold); retry++)
+            {
+                best_ms = minf(best_ms, time_frames(scene, options.frame_count, &frame_buffer));
+            }
+            change = best_ms / baseline_ms - 1.0f;
+            bool is_slower = change > options.threshold;
+            timing_result = is_slower ? "FAIL" : "pass";
+            is_failed = is_failed || is_slower;
+        }
+        else
+        {
+            skipped_timing_count++;
+            if (options.is_requiring_timings)
+            {
+                timing_result = "FAIL";
+                is_failed = true;
+            }
+        }
+
+        destroy_texture_manager(&scene.textures);
+        failure_count += is_failed;
+        printf("%s, %d, %d, %s, %.3f, %.3f, %+.1f%%, %s\n", test.name, bad_pixels, max_difference, image_result.c_str(), best_ms, baseline_ms, change * 100.0f, timing_result.c_str());
+        fflush(stdout);
+    }
+
+    if (options.is_updating_timings && !write_baseline(options.baseline, baseline)) return 1;
+    if (skipped_timing_count) printf("%d timings not compared, no baseline for %d threads in %s (run --update timings)\n", skipped_timing_count, options.thread_count, options.baseline.c_str());
+    printf("%d of %d cases passed\n", case_count - failure_count, case_count);
+    if (case_count == 0) std::cerr << "Error: no case matches the filter " << options.filter << "\n";
+
+    delete[] color.data;
+    destroy_worker_pool();
+    return failure_count || case_count == 0 ? 1 : 0;
+}
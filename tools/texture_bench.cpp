@@ -0,0 +1,165 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "Texture.h"
+#include "Simd.h"
+
+/**
+ * Texture layout micro-benchmark, linear rows against 4x4 tiled blocks.
+ *
+ * USAGE: texture_bench.exe [--size S] [--screen N]
+ *
+ * A screen of N x N pixels is mapped onto an S x S RGBA8 texture at one texel per pixel,
+ * rotated by 0 to 90 degrees, and bilinear sampled in scanline order, the way the
+ * rasterizer walks a textured polygon. For every angle and layout it prints
+ *
+ *      misses per sample, of a simulated 32 KiB 8-way LRU L1 with 64 byte lines
+ *      nanoseconds per sample, of the real sampler
+ */
+
+const int CACHE_LINE_SIZE = 64;
+const int CACHE_WAYS = 8;
+const int CACHE_SETS = (32 << 10) / (CACHE_LINE_SIZE * CACHE_WAYS);
+const int TIMING_REPEATS = 4;
+
+struct SimulatedCache
+{
+    uint64_t tags[CACHE_SETS][CACHE_WAYS];
+    uint64_t last_use[CACHE_SETS][CACHE_WAYS];
+    uint64_t clock;
+    uint64_t misses;
+};
+
+static void reset_cache(SimulatedCache& cache)
+{
+    memset(&cache, 0, sizeof(SimulatedCache));
+    for (int s = 0; s < CACHE_SETS; s++)
+    {
+        for (int w = 0; w < CACHE_WAYS; w++) cache.tags[s][w] = UINT64_MAX;
+    }
+}
+
+static void touch(SimulatedCache& cache, const void* address)
+{
+    uint64_t line = (uintptr_t) address / CACHE_LINE_SIZE;
+    int set = line % CACHE_SETS;
+    cache.clock++;
+
+    int oldest = 0;
+    for (int w = 0; w < CACHE_WAYS; w++)
+    {
+        if (cache.tags[set][w] == line)
+        {
+            cache.last_use[set][w] = cache.clock;
+            return;
+        }
+        if (cache.last_use[set][w] < cache.last_use[set][oldest]) oldest = w;
+    }
+
+    cache.misses++;
+    cache.tags[set][oldest] = line;
+    cache.last_use[set][oldest] = cache.clock;
+}
+
+// Same texel footprint as sample_bilinear
+static void touch_bilinear(SimulatedCache& cache, float u, float v, const Texture* texture)
+{
+    const TextureLevel& texels = texture->levels[0];
+    float x = u * texels.width - 0.5f, y = v * texels.height - 0.5f;
+    int x_floor = std::floor(x), y_floor = std::floor(y);
+
+    int xs[2] = { x_floor < 0 ? 0 : x_floor, x_floor + 1 < texels.width ? x_floor + 1 : texels.width - 1 };
+    int ys[2] = { y_floor < 0 ? 0 : y_floor, y_floor + 1 < texels.height ? y_floor + 1 : texels.height - 1 };
+    for (int j = 0; j < 2; j++)
+    {
+        for (int i = 0; i < 2; i++) touch(cache, texels.data + get_texel_index(xs[i], ys[j], texels.width, texture->layout) * texture->format);
+    }
+}
+
+// Screen pixel centers in scanline order, rotated around the texture's center
+static void get_sample_points(int screen_size, int texture_size, float degrees, std::vector<float>& us, std::vector<float>& vs)
+{
+    float radians = degrees * (3.14159265358979f / 180.0f);
+    float c = std::cos(radians), s = std::sin(radians);
+    us.clear();
+    vs.clear();
+    for (int y = 0; y < screen_size; y++)
+    {
+        for (int x = 0; x < screen_size; x++)
+        {
+            float dx = x + 0.5f - screen_size * 0.5f, dy = y + 0.5f - screen_size * 0.5f;
+            us.push_back(0.5f + (c * dx - s * dy) / texture_size);
+            vs.push_back(0.5f + (s * dx + c * dy) / texture_size);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int texture_size = 2048, screen_size = 1024;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (!strcmp(argv[i], "--size"))   texture_size = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--screen")) screen_size = atoi(argv[i + 1]);
+        else
+        {
+            std::cerr << "Error:: unknown option " << argv[i] << '\n';
+            return 1;
+        }
+    }
+    if (texture_size < 2 || screen_size < 1 || screen_size > texture_size)
+    {
+        std::cerr << "Error:: size must be at least 2, screen between 1 and size\n";
+        return 1;
+    }
+
+    Texture textures[2];
+    for (int l = 0; l < 2; l++)
+    {
+        init_texture(texture_size, texture_size, TEXTURE_RGBA8, TEXTURE_LINEAR, 1, &textures[l]);
+        for (size_t i = 0; i < textures[l].storage.size(); i++) textures[l].storage[i] = (i * 2654435761u) >> 24;
+    }
+    set_texture_layout(TEXTURE_TILED, &textures[1]);
+
+    std::cout << "texture " << texture_size << "x" << texture_size << " RGBA8, screen " << screen_size << "x" << screen_size << "\n";
+    std::cout << "degrees, linear misses/sample, tiled misses/sample, linear ns/sample, tiled ns/sample\n";
+
+    SimulatedCache* cache = new SimulatedCache();
+    std::vector<float> us, vs;
+    float checksum = 0.0f;
+    for (int degrees = 0; degrees <= 90; degrees += 15)
+    {
+        get_sample_points(screen_size, texture_size, degrees, us, vs);
+
+        double misses[2], nanoseconds[2];
+        for (int l = 0; l < 2; l++)
+        {
+            reset_cache(*cache);
+            for (int i = 0; i < us.size(); i++) touch_bilinear(*cache, us[i], vs[i], &textures[l]);
+            misses[l] = (double) cache->misses / us.size();
+
+            Float4 sum = float4(0.0f);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int r = 0; r < TIMING_REPEATS; r++)
+            {
+                for (int i = 0; i < us.size(); i++) sum = sum + sample_bilinear(us[i], vs[i], 0, &textures[l]);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            nanoseconds[l] = std::chrono::duration<double, std::nano>(end - start).count() / (us.size() * TIMING_REPEATS);
+
+            float lanes[4];
+            store_float4(lanes, sum);
+            checksum += lanes[0];
+        }
+
+        std::cout << degrees << ", " << misses[0] << ", " << misses[1] << ", " << nanoseconds[0] << ", " << nanoseconds[1] << '\n';
+    }
+
+    delete cache;
+    std::cout << "checksum " << checksum << '\n'; // keeps the timed loops from being optimized out
+    return 0;
+}